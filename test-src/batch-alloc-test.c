@@ -0,0 +1,129 @@
+// Copyright (C) 2017 BRK Brands, Inc. All Rights Reserved.
+/// @file
+/// Allocation failure test of cJSON_ParseBatch: parses the same input with
+/// allocator hooks that fail after 0, 1, 2, ... allocations, until one run gets
+/// through, and checks that every failed run frees all it allocated and that
+/// running out of memory never passes for invalid lines. Build and run with
+///
+///     gcc -g -fsanitize=address -I. -o batch-alloc-test batch-alloc-test.c cJSON.c -lm -lpthread && ./batch-alloc-test
+///
+/// Exits with 1 on the first failure.
+
+#include "cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Enough lines for four workers, see CJSON_BATCH_MIN_RANGE.
+#define LINE_COUNT      6000
+#define THREADS         4
+
+static long allocationsLeft = -1;
+static long liveAllocations = 0;
+
+static void *failingMalloc(size_t size)
+{
+    void *ptr = NULL;
+
+    // the workers allocate concurrently
+    if ((allocationsLeft >= 0) && (__atomic_fetch_sub(&allocationsLeft, 1, __ATOMIC_RELAXED) <= 0)) {
+        return NULL;
+    }
+    ptr = malloc(size);
+    if (ptr != NULL) {
+        __atomic_add_fetch(&liveAllocations, 1, __ATOMIC_RELAXED);
+    }
+    return ptr;
+}
+
+static void countingFree(void *ptr)
+{
+    if (ptr != NULL) {
+        __atomic_sub_fetch(&liveAllocations, 1, __ATOMIC_RELAXED);
+    }
+    free(ptr);
+}
+
+/// Newline delimited documents, every tenth line invalid.
+static char *makeInput(size_t *length)
+{
+    char *json = malloc(LINE_COUNT * 64);
+    size_t used = 0;
+    int i = 0;
+
+    for (i = 0; i < LINE_COUNT; i++) {
+        if (i % 10 == 9) {
+            used += sprintf(json + used, "{\"id\":%d,\n", i);
+        } else {
+            used += sprintf(json + used, "{\"id\":%d,\"name\":\"item %d\",\"tags\":[1,2,3]}\n", i, i);
+        }
+    }
+    *length = used;
+    return json;
+}
+
+static int checkBatch(const cJSON_Batch *batch)
+{
+    size_t i = 0;
+
+    if (cJSON_GetBatchSize(batch) != LINE_COUNT) {
+        printf("batch has %zu items, expected %d\n", cJSON_GetBatchSize(batch), LINE_COUNT);
+        return 0;
+    }
+    for (i = 0; i < LINE_COUNT; i++) {
+        cJSON *item = cJSON_GetBatchItem(batch, i);
+        if ((i % 10 == 9) != (item == NULL)) {
+            printf("item %zu parsed wrong\n", i);
+            return 0;
+        }
+        if ((item != NULL) && (cJSON_GetObjectItem(item, "id")->valueint != (int)i)) {
+            printf("item %zu out of order\n", i);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/// Fails allocations one after another until a batch gets through.
+static int runWithFlags(const char *json, size_t length, int flags)
+{
+    cJSON_Batch *batch = NULL;
+    long limit = 0;
+
+    for (limit = 0; batch == NULL; limit++) {
+        allocationsLeft = limit;
+        batch = cJSON_ParseBatch(json, length, flags, THREADS);
+        if ((batch == NULL) && (liveAllocations != 0)) {
+            printf("flags %d: failing after %ld allocations leaks %ld\n", flags, limit, liveAllocations);
+            return 0;
+        }
+    }
+    allocationsLeft = -1;
+
+    if (!checkBatch(batch)) {
+        return 0;
+    }
+    cJSON_DeleteBatch(batch);
+    if (liveAllocations != 0) {
+        printf("flags %d: cJSON_DeleteBatch leaks %ld\n", flags, liveAllocations);
+        return 0;
+    }
+
+    printf("flags %d: %ld allocation failures handled\n", flags, limit - 1);
+    return 1;
+}
+
+int main(void)
+{
+    cJSON_Hooks hooks = { failingMalloc, countingFree };
+    size_t length = 0;
+    char *json = makeInput(&length);
+    int ok = 0;
+
+    cJSON_InitHooks(&hooks);
+    ok = runWithFlags(json, length, 0)
+        && runWithFlags(json, length, cJSON_ParseInternKeys | cJSON_ParseBuildIndex);
+
+    free(json);
+    return ok ? 0 : 1;
+}
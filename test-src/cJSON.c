@@ -23,6 +23,22 @@
 /* cJSON */
 /* JSON parser in C. */
 
+/* SSE2 versions of the scanning loops on x86, AVX2 ones are picked at runtime if the compiler can build them */
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))) && !defined(CJSON_NO_SIMD)
+#define CJSON_SIMD_SSE2
+#if defined(__clang__) || (__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9))
+#define CJSON_SIMD_AVX2
+#endif
+#endif
+
+/* cJSON_ParseBatch runs its workers on POSIX threads, define CJSON_NO_THREADS to parse on the calling thread only */
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(CJSON_NO_THREADS)
+#define CJSON_THREADS
+#if !defined(_POSIX_C_SOURCE) && !defined(_GNU_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+#endif
+
 #ifdef __GNUC__
 #pragma GCC visibility push(default)
 #endif
@@ -35,6 +51,14 @@
 #include <limits.h>
 #include <ctype.h>
 #include <locale.h>
+#include <stdint.h>
+#if defined(CJSON_SIMD_SSE2)
+#include <immintrin.h>
+#endif
+#if defined(CJSON_THREADS)
+#include <pthread.h>
+#include <unistd.h>
+#endif
 
 #ifdef __GNUC__
 #pragma GCC visibility pop
@@ -103,921 +127,4839 @@ typedef struct internal_hooks
     void *(*allocate)(size_t size);
     void (*deallocate)(void *pointer);
     void *(*reallocate)(void *pointer, size_t size);
+    /* if not NULL, items and strings are allocated from this arena instead */
+    cJSON_Arena *arena;
 } internal_hooks;
 
-static internal_hooks global_hooks = { malloc, free, realloc };
+static internal_hooks global_hooks = { malloc, free, realloc, NULL };
 
-static unsigned char* cJSON_strdup(const unsigned char* string, const internal_hooks * const hooks)
+/* Arena allocator: memory is handed out from large blocks by bumping an offset and
+ * is only given back when the whole arena is reset or deleted. */
+#define CJSON_ARENA_DEFAULT_BLOCK_SIZE 8192
+/* enough for any of the types stored in the arena (pointers, doubles, size_t) */
+#define CJSON_ARENA_ALIGNMENT (2 * sizeof(void*))
+#define arena_align(size) (((size) + (CJSON_ARENA_ALIGNMENT - 1)) & ~(CJSON_ARENA_ALIGNMENT - 1))
+
+typedef struct arena_block
 {
-    size_t length = 0;
-    unsigned char *copy = NULL;
+    struct arena_block *next;
+    size_t size; /* usable bytes after the header */
+    size_t used;
+} arena_block;
 
-    if (string == NULL)
+#define arena_block_header_size arena_align(sizeof(arena_block))
+#define arena_block_data(block) ((unsigned char*)(block) + arena_block_header_size)
+
+struct cJSON_Arena
+{
+    arena_block *blocks; /* the block currently allocated from comes first */
+    size_t block_size;
+    internal_hooks hooks; /* where the blocks come from */
+    cJSON_bool out_of_memory; /* an allocation failed, so a failed parse isn't necessarily invalid JSON */
+};
+
+static arena_block *arena_new_block(cJSON_Arena * const arena, size_t size)
+{
+    arena_block *block = NULL;
+
+    if (size > ((size_t)-1 - arena_block_header_size))
     {
         return NULL;
     }
 
-    length = strlen((const char*)string) + sizeof("");
-    if (!(copy = (unsigned char*)hooks->allocate(length)))
+    block = (arena_block*)arena->hooks.allocate(arena_block_header_size + size);
+    if (block != NULL)
     {
-        return NULL;
+        block->next = NULL;
+        block->size = size;
+        block->used = 0;
     }
-    memcpy(copy, string, length);
 
-    return copy;
+    return block;
 }
 
-CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks)
+static void *arena_allocate(cJSON_Arena * const arena, size_t size)
 {
-    if (hooks == NULL)
+    arena_block *block = arena->blocks;
+    void *memory = NULL;
+
+    if (size > ((size_t)-1 - CJSON_ARENA_ALIGNMENT))
     {
-        /* Reset hooks */
-        global_hooks.allocate = malloc;
-        global_hooks.deallocate = free;
-        global_hooks.reallocate = realloc;
-        return;
+        return NULL;
     }
+    size = arena_align(size);
 
-    global_hooks.allocate = malloc;
-    if (hooks->malloc_fn != NULL)
+    if ((block != NULL) && (size <= (block->size - block->used)))
     {
-        global_hooks.allocate = hooks->malloc_fn;
+        memory = arena_block_data(block) + block->used;
+        block->used += size;
+        return memory;
     }
 
-    global_hooks.deallocate = free;
-    if (hooks->free_fn != NULL)
+    if (size > (arena->block_size / 2))
     {
-        global_hooks.deallocate = hooks->free_fn;
+        /* big allocations get a block of their own, so the space left in the
+         * current block can still be used */
+        arena_block *big = arena_new_block(arena, size);
+        if (big == NULL)
+        {
+            arena->out_of_memory = true;
+            return NULL;
+        }
+        big->used = size;
+        if (block != NULL)
+        {
+            big->next = block->next;
+            block->next = big;
+        }
+        else
+        {
+            arena->blocks = big;
+        }
+        return arena_block_data(big);
     }
 
-    /* use realloc only if both free and malloc are used */
-    global_hooks.reallocate = NULL;
-    if ((global_hooks.allocate == malloc) && (global_hooks.deallocate == free))
+    block = arena_new_block(arena, arena->block_size);
+    if (block == NULL)
     {
-        global_hooks.reallocate = realloc;
+        arena->out_of_memory = true;
+        return NULL;
     }
+    block->next = arena->blocks;
+    arena->blocks = block;
+    block->used = size;
+
+    return arena_block_data(block);
 }
 
-/* Internal constructor. */
-static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
+CJSON_PUBLIC(cJSON_Arena *) cJSON_CreateArena(size_t block_size)
 {
-    cJSON* node = (cJSON*)hooks->allocate(sizeof(cJSON));
-    if (node)
+    cJSON_Arena *arena = (cJSON_Arena*)global_hooks.allocate(sizeof(cJSON_Arena));
+    if (arena == NULL)
     {
-        memset(node, '\0', sizeof(cJSON));
+        return NULL;
     }
 
-    return node;
+    arena->blocks = NULL;
+    arena->block_size = (block_size > 0) ? arena_align(block_size) : CJSON_ARENA_DEFAULT_BLOCK_SIZE;
+    arena->hooks = global_hooks;
+    arena->out_of_memory = false;
+
+    return arena;
 }
 
-/* Delete a cJSON structure. */
-CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
+CJSON_PUBLIC(void) cJSON_ResetArena(cJSON_Arena *arena)
 {
-    cJSON *next = NULL;
-    while (item != NULL)
+    arena_block *block = NULL;
+    arena_block *keep = NULL;
+
+    if (arena == NULL)
     {
-        next = item->next;
-        if (!(item->type & cJSON_IsReference) && (item->child != NULL))
-        {
-            cJSON_Delete(item->child);
-        }
-        if (!(item->type & cJSON_IsReference) && (item->valuestring != NULL))
+        return;
+    }
+
+    /* keep one regular sized block around for the next document */
+    block = arena->blocks;
+    while (block != NULL)
+    {
+        arena_block *next = block->next;
+        if ((keep == NULL) && (block->size == arena->block_size))
         {
-            global_hooks.deallocate(item->valuestring);
+            keep = block;
+            keep->next = NULL;
+            keep->used = 0;
         }
-        if (!(item->type & cJSON_StringIsConst) && (item->string != NULL))
+        else
         {
-            global_hooks.deallocate(item->string);
+            arena->hooks.deallocate(block);
         }
-        global_hooks.deallocate(item);
-        item = next;
+        block = next;
     }
+    arena->blocks = keep;
 }
 
-/* get the decimal point character of the current locale */
-static unsigned char get_decimal_point(void)
+CJSON_PUBLIC(void) cJSON_DeleteArena(cJSON_Arena *arena)
 {
-    struct lconv *lconv = localeconv();
-    return (unsigned char) lconv->decimal_point[0];
+    if (arena == NULL)
+    {
+        return;
+    }
+
+    cJSON_ResetArena(arena);
+    if (arena->blocks != NULL)
+    {
+        arena->hooks.deallocate(arena->blocks);
+    }
+    arena->hooks.deallocate(arena);
 }
 
-typedef struct
+CJSON_PUBLIC(void *) cJSON_ArenaMalloc(cJSON_Arena *arena, size_t size)
 {
-    const unsigned char *content;
-    size_t length;
-    size_t offset;
-    size_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset. */
-    internal_hooks hooks;
-} parse_buffer;
+    if (arena == NULL)
+    {
+        return NULL;
+    }
 
-/* check if the given size is left to read in a given parse buffer (starting with 1) */
-#define can_read(buffer, size) ((buffer != NULL) && (((buffer)->offset + size) <= (buffer)->length))
-//#define cannot_read(buffer, size) (!can_read(buffer, size))
-/* check if the buffer can be accessed at the given index (starting with 0) */
-#define can_access_at_index(buffer, index) ((buffer != NULL) && (((buffer)->offset + index) < (buffer)->length))
-#define cannot_access_at_index(buffer, index) (!can_access_at_index(buffer, index))
-/* get a pointer to the buffer at the position */
-#define buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
+    return arena_allocate(arena, size);
+}
 
-/* Parse the input text to generate a number, and populate the result into item. */
-static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
+/* allocate from the arena if there is one, otherwise from the hooks */
+static void *internal_allocate(const internal_hooks * const hooks, size_t size)
 {
-    double number = 0;
-    unsigned char *after_end = NULL;
-    unsigned char number_c_string[64];
-    unsigned char decimal_point = get_decimal_point();
-    size_t i = 0;
-
-    if ((input_buffer == NULL) || (input_buffer->content == NULL))
+    if (hooks->arena != NULL)
     {
-        return false;
+        return arena_allocate(hooks->arena, size);
     }
 
-    /* copy the number into a temporary buffer and replace '.' with the decimal point
-     * of the current locale (for strtod)
-     * This also takes care of '\0' not necessarily being available for marking the end of the input */
-    for (i = 0; (i < (sizeof(number_c_string) - 1)) && can_access_at_index(input_buffer, i); i++)
-    {
-        switch (buffer_at_offset(input_buffer)[i])
-        {
-            case '0':
-            case '1':
-            case '2':
-            case '3':
-            case '4':
-            case '5':
-            case '6':
-            case '7':
-            case '8':
-            case '9':
-            case '+':
-            case '-':
-            case 'e':
-            case 'E':
-                number_c_string[i] = buffer_at_offset(input_buffer)[i];
-                break;
-
-            case '.':
-                number_c_string[i] = decimal_point;
-                break;
-
-            default:
-                goto loop_end;
-        }
-    }
-loop_end:
-    number_c_string[i] = '\0';
+    return hooks->allocate(size);
+}
 
-    number = strtod((const char*)number_c_string, (char**)&after_end);
-    if (number_c_string == after_end)
+/* arena memory is only released with the arena */
+static void internal_deallocate(const internal_hooks * const hooks, void *pointer)
+{
+    if (hooks->arena == NULL)
     {
-        return false; /* parse_error */
+        hooks->deallocate(pointer);
     }
+}
 
-    item->valuedouble = number;
+/* global hooks, but allocating from the given arena */
+static internal_hooks arena_hooks(cJSON_Arena * const arena)
+{
+    internal_hooks hooks = global_hooks;
+    hooks.arena = arena;
 
-    /* use saturation in case of overflow */
-    if (number >= INT_MAX)
-    {
-        item->valueint = INT_MAX;
-    }
-    else if (number <= INT_MIN)
+    return hooks;
+}
+
+static unsigned char* cJSON_strdup(const unsigned char* string, const internal_hooks * const hooks)
+{
+    size_t length = 0;
+    unsigned char *copy = NULL;
+
+    if (string == NULL)
     {
-        item->valueint = INT_MIN;
+        return NULL;
     }
-    else
+
+    length = strlen((const char*)string) + sizeof("");
+    if (!(copy = (unsigned char*)internal_allocate(hooks, length)))
     {
-        item->valueint = (int)number;
+        return NULL;
     }
+    memcpy(copy, string, length);
 
-    item->type = cJSON_Number;
-
-    input_buffer->offset += (size_t)(after_end - number_c_string);
-    return true;
+    return copy;
 }
 
-/* don't ask me, but the original cJSON_SetNumberValue returns an integer or double */
-CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number)
+/* Turn user supplied hooks into internal ones, NULL or missing functions mean malloc and free. */
+static void set_hooks(internal_hooks * const internal, const cJSON_Hooks * const hooks)
 {
-    if (number >= INT_MAX)
+    internal->allocate = malloc;
+    internal->deallocate = free;
+    internal->reallocate = realloc;
+    if (hooks == NULL)
     {
-        object->valueint = INT_MAX;
+        return;
     }
-    else if (number <= INT_MIN)
+
+    if (hooks->malloc_fn != NULL)
     {
-        object->valueint = INT_MIN;
+        internal->allocate = hooks->malloc_fn;
     }
-    else
+
+    if (hooks->free_fn != NULL)
     {
-        object->valueint = (int)number;
+        internal->deallocate = hooks->free_fn;
     }
 
-    return object->valuedouble = number;
+    /* use realloc only if both free and malloc are used */
+    internal->reallocate = NULL;
+    if ((internal->allocate == malloc) && (internal->deallocate == free))
+    {
+        internal->reallocate = realloc;
+    }
 }
 
-typedef struct
+CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks)
+{
+    set_hooks(&global_hooks, hooks);
+}
+
+struct cJSON_Context
 {
-    unsigned char *buffer;
-    size_t length;
-    size_t offset;
-    size_t depth; /* current nesting depth (for formatted printing) */
-    cJSON_bool noalloc;
-    cJSON_bool format; /* is this print a formatted print */
     internal_hooks hooks;
-} printbuffer;
+    error error; /* where the last failed parse stopped */
+    size_t nesting_limit;
+    int flags; /* cJSON_Parse... option flags */
+};
 
-/* realloc printbuffer if necessary to have at least "needed" bytes more */
-static unsigned char* ensure(printbuffer * const p, size_t needed)
+CJSON_PUBLIC(cJSON_Context *) cJSON_CreateContext(const cJSON_Hooks *hooks)
 {
-    unsigned char *newbuffer = NULL;
-    size_t newsize = 0;
+    internal_hooks context_hooks = { 0, 0, 0, 0 };
+    cJSON_Context *context = NULL;
 
-    if ((p == NULL) || (p->buffer == NULL))
+    set_hooks(&context_hooks, hooks);
+    context = (cJSON_Context*)context_hooks.allocate(sizeof(cJSON_Context));
+    if (context == NULL)
     {
         return NULL;
     }
+    memset(context, '\0', sizeof(cJSON_Context));
+    context->hooks = context_hooks;
+    context->nesting_limit = CJSON_NESTING_LIMIT;
 
-    if ((p->length > 0) && (p->offset >= p->length))
+    return context;
+}
+
+CJSON_PUBLIC(void) cJSON_DeleteContext(cJSON_Context *context)
+{
+    if (context != NULL)
     {
-        /* make sure that offset is valid */
-        return NULL;
+        context->hooks.deallocate(context);
     }
+}
 
-    if (needed > INT_MAX)
+CJSON_PUBLIC(void) cJSON_SetNestingLimit(cJSON_Context *context, size_t limit)
+{
+    if (context != NULL)
     {
-        /* sizes bigger than INT_MAX are currently not supported */
-        return NULL;
+        context->nesting_limit = limit;
     }
+}
 
-    needed += p->offset + 1;
-    if (needed <= p->length)
+CJSON_PUBLIC(void) cJSON_SetParseFlags(cJSON_Context *context, int flags)
+{
+    if (context != NULL)
     {
-        return p->buffer + p->offset;
+        context->flags = flags;
     }
+}
 
-    if (p->noalloc) {
+CJSON_PUBLIC(const char *) cJSON_GetContextError(const cJSON_Context *context)
+{
+    if ((context == NULL) || (context->error.json == NULL))
+    {
         return NULL;
     }
 
-    /* calculate new buffer size */
-    if (needed > (INT_MAX / 2))
+    return (const char*) (context->error.json + context->error.position);
+}
+
+/* Internal constructor. */
+static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
+{
+    cJSON* node = (cJSON*)internal_allocate(hooks, sizeof(cJSON));
+    if (node)
     {
-        /* overflow of int, use INT_MAX if possible */
-        if (needed <= INT_MAX)
-        {
-            newsize = INT_MAX;
-        }
-        else
+        memset(node, '\0', sizeof(cJSON));
+        if (hooks->arena != NULL)
         {
-            return NULL;
+            node->type = cJSON_InArena;
         }
     }
-    else
+
+    return node;
+}
+
+/* Lookup index of an array or object: the children in order, so they can be
+ * found by position without walking the list. */
+typedef struct cJSON_Index
+{
+    size_t count; /* number of children in items */
+    size_t capacity;
+    cJSON *items[];
+} cJSON_Index;
+
+#define index_size(capacity) (sizeof(cJSON_Index) + ((capacity) * sizeof(cJSON*)))
+
+/* Drop the index of an item, e.g. because its children changed. */
+static void index_free(cJSON * const item)
+{
+    if (item->index == NULL)
     {
-        newsize = needed * 2;
+        return;
     }
 
-    if (p->hooks.reallocate != NULL)
+    /* indexes of arena items live in the arena */
+    if (!(item->type & cJSON_InArena))
     {
-        /* reallocate with realloc if available */
-        newbuffer = (unsigned char*)p->hooks.reallocate(p->buffer, newsize);
+        global_hooks.deallocate(item->index);
     }
-    else
+    item->index = NULL;
+}
+
+/* Build the index of an array or object. */
+static cJSON_bool index_build(cJSON * const item, const internal_hooks * const hooks)
+{
+    cJSON_Index *index = NULL;
+    cJSON *child = NULL;
+    size_t count = 0;
+
+    for (child = item->child; child != NULL; child = child->next)
     {
-        /* otherwise reallocate manually */
-        newbuffer = (unsigned char*)p->hooks.allocate(newsize);
-        if (!newbuffer)
-        {
-            p->hooks.deallocate(p->buffer);
-            p->length = 0;
-            p->buffer = NULL;
-
-            return NULL;
-        }
-        if (newbuffer)
-        {
-            memcpy(newbuffer, p->buffer, p->offset + 1);
-        }
-        p->hooks.deallocate(p->buffer);
+        count++;
     }
-    p->length = newsize;
-    p->buffer = newbuffer;
 
-    return newbuffer + p->offset;
-}
+    if (count > (((size_t)-1 - sizeof(cJSON_Index)) / sizeof(cJSON*)))
+    {
+        return false;
+    }
+    index = (cJSON_Index*)internal_allocate(hooks, index_size(count));
+    if (index == NULL)
+    {
+        return false;
+    }
 
-/* calculate the new length of the string in a printbuffer and update the offset */
-static void update_offset(printbuffer * const buffer)
-{
-    const unsigned char *buffer_pointer = NULL;
-    if ((buffer == NULL) || (buffer->buffer == NULL))
+    index->count = 0;
+    index->capacity = count;
+    for (child = item->child; child != NULL; child = child->next)
     {
-        return;
+        index->items[index->count++] = child;
     }
-    buffer_pointer = buffer->buffer + buffer->offset;
 
-    buffer->offset += strlen((const char*)buffer_pointer);
+    index_free(item);
+    item->index = index;
+
+    return true;
 }
 
-/* Render the number nicely from the given item into a string. */
-static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer)
+/* Keep the index up to date when item is appended to parent. */
+static void index_append(cJSON * const parent, cJSON * const item)
 {
-    unsigned char *output_pointer = NULL;
-    double d = item->valuedouble;
-    int length = 0;
-    size_t i = 0;
-    unsigned char number_buffer[26]; /* temporary buffer to print the number into */
-    unsigned char decimal_point = get_decimal_point();
-    double test;
+    cJSON_Index *index = parent->index;
 
-    if (output_buffer == NULL)
+    if (index == NULL)
     {
-        return false;
+        return;
     }
 
-    /* This checks for NaN and Infinity */
-    if ((d * 0) != 0)
-    {
-        length = sprintf((char*)number_buffer, "null");
-    }
-    else
+    if (index->count == index->capacity)
     {
-        /* Try 15 decimal places of precision to avoid nonsignificant nonzero digits */
-        length = sprintf((char*)number_buffer, "%1.15g", d);
+        cJSON_Index *grown = NULL;
+        size_t capacity = (index->capacity < 4) ? 8 : (index->capacity * 2);
 
-        /* Check whether the original double can be recovered */
-        if ((sscanf((char*)number_buffer, "%lg", &test) != 1) || ((double)test != d))
+        /* arena memory can't be reallocated, the index is dropped instead */
+        if ((parent->type & cJSON_InArena) || (global_hooks.reallocate == NULL)
+                || (capacity > (((size_t)-1 - sizeof(cJSON_Index)) / sizeof(cJSON*))))
         {
-            /* If not, print with 17 decimal places of precision */
-            length = sprintf((char*)number_buffer, "%1.17g", d);
+            index_free(parent);
+            return;
         }
+        grown = (cJSON_Index*)global_hooks.reallocate(index, index_size(capacity));
+        if (grown == NULL)
+        {
+            index_free(parent);
+            return;
+        }
+        grown->capacity = capacity;
+        parent->index = index = grown;
     }
 
-    /* sprintf failed or buffer overrun occured */
-    if ((length < 0) || (length > (int)(sizeof(number_buffer) - 1)))
-    {
-        return false;
-    }
+    index->items[index->count++] = item;
+}
 
-    /* reserve appropriate space in the output */
-    output_pointer = ensure(output_buffer, (size_t)length);
-    if (output_pointer == NULL)
-    {
-        return false;
-    }
+/* Hash table over the keys of an object. It uses open addressing with linear
+ * probing and hashes keys case insensitively, so both flavours of
+ * get_object_item can use it. */
+typedef struct
+{
+    size_t hash;
+    cJSON *item; /* NULL if the slot is free */
+} key_slot;
 
-    /* copy the printed number to the output and replace locale
-     * dependent decimal point with '.' */
-    for (i = 0; i < ((size_t)length); i++)
-    {
-        if (number_buffer[i] == decimal_point)
-        {
-            output_pointer[i] = '.';
-            continue;
-        }
+typedef struct cJSON_KeyTable
+{
+    size_t count; /* number of used slots */
+    size_t mask; /* number of slots - 1, the number of slots is a power of two */
+    key_slot slots[];
+} cJSON_KeyTable;
+
+#define key_table_size(slots) (sizeof(cJSON_KeyTable) + ((slots) * sizeof(key_slot)))
+
+/* Tables of objects shared between threads are built on first lookup, so they are published atomically. */
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE)
+#define load_key_table(object) __atomic_load_n(&(object)->keys, __ATOMIC_ACQUIRE)
+#define publish_key_table(object, expected, table) \
+    __atomic_compare_exchange_n(&(object)->keys, &(expected), (table), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#else
+#define load_key_table(object) ((object)->keys)
+#define publish_key_table(object, expected, table) (((object)->keys = (table)), true)
+#endif
 
-        output_pointer[i] = number_buffer[i];
-    }
-    output_pointer[i] = '\0';
+/* Case is ignored by setting bit 5, which is what tolower does to ASCII (and Latin-1) letters,
+ * without calling it for every character. Other characters that end up alike just share a hash. */
+static size_t hash_key(const unsigned char *key)
+{
+    size_t hash = 5381;
 
-    output_buffer->offset += (size_t)length;
+    for (; *key != '\0'; key++)
+    {
+        hash = (hash * 33) ^ (size_t)(*key | 0x20);
+    }
 
-    return true;
+    return hash;
 }
 
-/* parse 4 digit hexadecimal number */
-static unsigned parse_hex4(const unsigned char * const input)
+/* hash_key of the first length bytes of key */
+static size_t hash_key_length(const unsigned char *key, size_t length)
 {
-    unsigned int h = 0;
-    size_t i = 0;
+    size_t hash = 5381;
+    const unsigned char * const end = key + length;
 
-    for (i = 0; i < 4; i++)
+    for (; key < end; key++)
     {
-        /* parse digit */
-        if ((input[i] >= '0') && (input[i] <= '9'))
-        {
-            h += (unsigned int) input[i] - '0';
-        }
-        else if ((input[i] >= 'A') && (input[i] <= 'F'))
-        {
-            h += (unsigned int) 10 + input[i] - 'A';
-        }
-        else if ((input[i] >= 'a') && (input[i] <= 'f'))
-        {
-            h += (unsigned int) 10 + input[i] - 'a';
-        }
-        else /* invalid */
-        {
-            return 0;
-        }
-
-        if (i < 3)
-        {
-            /* shift left to make place for the next nibble */
-            h = h << 4;
-        }
+        hash = (hash * 33) ^ (size_t)(*key | 0x20);
     }
 
-    return h;
+    return hash;
 }
 
-/* converts a UTF-16 literal to UTF-8
- * A literal can be one or two sequences of the form \uXXXX */
-static unsigned char utf16_literal_to_utf8(const unsigned char * const input_pointer, const unsigned char * const input_end, unsigned char **output_pointer)
+/* Keys that several items share, see cJSON_ParseInternKeys. The number of items using
+ * the key, its hash and its length are stored in front of the characters. */
+typedef struct
 {
-    long unsigned int codepoint = 0;
-    unsigned int first_code = 0;
-    const unsigned char *first_sequence = input_pointer;
-    unsigned char utf8_length = 0;
-    unsigned char utf8_position = 0;
-    unsigned char sequence_length = 0;
-    unsigned char first_byte_mark = 0;
+    size_t references;
+    size_t hash;
+    size_t length;
+} shared_key;
 
-    if ((input_end - first_sequence) < 6)
+#define shared_key_header(key) ((shared_key*)(void*)((key) - sizeof(shared_key)))
+
+/* the items of a document can end up in different threads */
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE)
+#define shared_key_retain(key) ((void)__atomic_add_fetch(&shared_key_header(key)->references, 1, __ATOMIC_RELAXED))
+#define shared_key_drop(key) (__atomic_sub_fetch(&shared_key_header(key)->references, 1, __ATOMIC_ACQ_REL) == 0)
+#else
+#define shared_key_retain(key) ((void)shared_key_header(key)->references++)
+#define shared_key_drop(key) (--shared_key_header(key)->references == 0)
+#endif
+
+/* Create a shared key with one reference. */
+static char *shared_key_create(const unsigned char * const string, const size_t length, const size_t hash, const internal_hooks * const hooks)
+{
+    shared_key *header = NULL;
+    char *key = NULL;
+
+    header = (shared_key*)internal_allocate(hooks, sizeof(shared_key) + length + sizeof(""));
+    if (header == NULL)
     {
-        /* input ends unexpectedly */
-        goto fail;
+        return NULL;
     }
+    header->references = 1;
+    header->hash = hash;
+    header->length = length;
 
-    /* get the first utf16 sequence */
-    first_code = parse_hex4(first_sequence + 2);
+    key = (char*)(header + 1);
+    memcpy(key, string, length);
+    key[length] = '\0';
 
-    /* check that the code is valid */
-    if (((first_code >= 0xDC00) && (first_code <= 0xDFFF)))
+    return key;
+}
+
+static void shared_key_release(char * const key, const internal_hooks * const hooks)
+{
+    if (shared_key_drop(key))
     {
-        goto fail;
+        hooks->deallocate(shared_key_header(key));
     }
+}
 
-    /* UTF16 surrogate pair */
-    if ((first_code >= 0xD800) && (first_code <= 0xDBFF))
+/* hash_key of the key of an item, shared keys know it already */
+static size_t item_key_hash(const cJSON * const item)
+{
+    if (item->type & cJSON_KeyIsShared)
     {
-        const unsigned char *second_sequence = first_sequence + 6;
-        unsigned int second_code = 0;
-        sequence_length = 12; /* \uXXXX\uXXXX */
-
-        if ((input_end - second_sequence) < 6)
-        {
-            /* input ends unexpectedly */
-            goto fail;
-        }
-
-        if ((second_sequence[0] != '\\') || (second_sequence[1] != 'u'))
-        {
-            /* missing second half of the surrogate pair */
-            goto fail;
-        }
+        return shared_key_header(item->string)->hash;
+    }
 
-        /* get the second utf16 sequence */
-        second_code = parse_hex4(second_sequence + 2);
-        /* check that the code is valid */
-        if ((second_code < 0xDC00) || (second_code > 0xDFFF))
-        {
-            /* invalid second half of the surrogate pair */
-            goto fail;
-        }
+    return hash_key((const unsigned char*)item->string);
+}
 
+/* Free the key of an item, unless it is constant or belongs to an arena. */
+static void release_key(cJSON * const item, const internal_hooks * const hooks)
+{
+    if ((item->string == NULL) || (item->type & (cJSON_StringIsConst | cJSON_InArena)))
+    {
+        return;
+    }
 
-        /* calculate the unicode codepoint from the surrogate pair */
-        codepoint = 0x10000 + (((first_code & 0x3FF) << 10) | (second_code & 0x3FF));
+    if (item->type & cJSON_KeyIsShared)
+    {
+        shared_key_release(item->string, hooks);
     }
     else
     {
-        sequence_length = 6; /* \uXXXX */
-        codepoint = first_code;
+        hooks->deallocate(item->string);
     }
+}
 
-    /* encode as UTF-8
-     * takes at maximum 4 bytes to encode:
-     * 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
-    if (codepoint < 0x80)
+/* Drop the key table of an object. */
+static void key_table_free(cJSON * const object)
+{
+    if (object->keys == NULL)
     {
-        /* normal ascii, encoding 0xxxxxxx */
-        utf8_length = 1;
+        return;
     }
-    else if (codepoint < 0x800)
+
+    /* tables of arena items live in the arena */
+    if (!(object->type & cJSON_InArena))
     {
-        /* two bytes, encoding 110xxxxx 10xxxxxx */
-        utf8_length = 2;
-        first_byte_mark = 0xC0; /* 11000000 */
+        global_hooks.deallocate(object->keys);
     }
-    else if (codepoint < 0x10000)
+    object->keys = NULL;
+}
+
+static void key_table_put(cJSON_KeyTable * const table, const size_t hash, cJSON * const item)
+{
+    size_t position = hash & table->mask;
+
+    while (table->slots[position].item != NULL)
     {
-        /* three bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx */
-        utf8_length = 3;
-        first_byte_mark = 0xE0; /* 11100000 */
+        position = (position + 1) & table->mask;
     }
-    else if (codepoint <= 0x10FFFF)
+    table->slots[position].hash = hash;
+    table->slots[position].item = item;
+    table->count++;
+}
+
+/* Create a table for the children of object. */
+static cJSON_KeyTable *key_table_create(const cJSON * const object, const internal_hooks * const hooks)
+{
+    cJSON_KeyTable *table = NULL;
+    cJSON *child = NULL;
+    size_t count = 0;
+    size_t slots = 8;
+
+    for (child = object->child; child != NULL; child = child->next)
     {
-        /* four bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx 10xxxxxx */
-        utf8_length = 4;
-        first_byte_mark = 0xF0; /* 11110000 */
+        count++;
     }
-    else
+    /* keep the load factor at 1/2 or less */
+    while (slots < (count * 2))
     {
-        /* invalid unicode codepoint */
-        goto fail;
+        if (slots > (((size_t)-1 - sizeof(cJSON_KeyTable)) / sizeof(key_slot) / 2))
+        {
+            return NULL;
+        }
+        slots *= 2;
     }
 
-    /* encode as utf8 */
-    for (utf8_position = (unsigned char)(utf8_length - 1); utf8_position > 0; utf8_position--)
+    table = (cJSON_KeyTable*)internal_allocate(hooks, key_table_size(slots));
+    if (table == NULL)
     {
-        /* 10xxxxxx */
-        (*output_pointer)[utf8_position] = (unsigned char)((codepoint | 0x80) & 0xBF);
-        codepoint >>= 6;
+        return NULL;
     }
-    /* encode first byte */
-    if (utf8_length > 1)
+    memset(table, '\0', key_table_size(slots));
+    table->mask = slots - 1;
+
+    for (child = object->child; child != NULL; child = child->next)
     {
-        (*output_pointer)[0] = (unsigned char)((codepoint | first_byte_mark) & 0xFF);
+        if (child->string != NULL)
+        {
+            key_table_put(table, item_key_hash(child), child);
+        }
     }
-    else
+
+    return table;
+}
+
+/* Build the key table of an object. */
+static cJSON_bool key_table_build(cJSON * const object, const internal_hooks * const hooks)
+{
+    cJSON_KeyTable *table = key_table_create(object, hooks);
+    if (table == NULL)
     {
-        (*output_pointer)[0] = (unsigned char)(codepoint & 0x7F);
+        return false;
     }
 
-    *output_pointer += utf8_length;
-
-    return sequence_length;
+    key_table_free(object);
+    object->keys = table;
 
-fail:
-    return 0;
+    return true;
 }
 
-/* Parse the input text into an unescaped cinput, and populate item. */
-static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_buffer)
+/* Keep the key table up to date when item has been linked into object. */
+static void key_table_add(cJSON * const object, cJSON * const item)
 {
-    const unsigned char *input_pointer = buffer_at_offset(input_buffer) + 1;
-    const unsigned char *input_end = buffer_at_offset(input_buffer) + 1;
-    unsigned char *output_pointer = NULL;
-    unsigned char *output = NULL;
+    cJSON_KeyTable *table = object->keys;
 
-    /* not a string */
-    if (buffer_at_offset(input_buffer)[0] != '\"')
+    if ((table == NULL) || (item->string == NULL))
     {
-        goto fail;
+        return;
     }
 
+    if (((table->count + 1) * 2) > (table->mask + 1))
     {
-        /* calculate approximate size of the output (overestimate) */
-        size_t allocation_length = 0;
-        size_t skipped_bytes = 0;
-        while ((*input_end != '\"') && ((size_t)(input_end - input_buffer->content) < input_buffer->length))
-        {
-            /* is escape sequence */
-            if (input_end[0] == '\\')
-            {
-                if ((size_t)(input_end + 1 - input_buffer->content) >= input_buffer->length)
-                {
-                    /* prevent buffer overflow when last input character is a backslash */
-                    goto fail;
-                }
-                skipped_bytes++;
-                input_end++;
-            }
-            input_end++;
-        }
-        if (*input_end != '\"')
-        {
-            goto fail; /* string ended unexpectedly */
-        }
-
-        /* This is at most how much we need for the output */
-        allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
-        output = (unsigned char*)input_buffer->hooks.allocate(allocation_length + sizeof(""));
-        if (output == NULL)
+        /* arena memory can't be freed, the table is dropped instead */
+        if ((object->type & cJSON_InArena) || !key_table_build(object, &global_hooks))
         {
-            goto fail; /* allocation failure */
+            key_table_free(object);
         }
+        return;
     }
 
-    output_pointer = output;
-    /* loop through the string literal */
-    while (input_pointer < input_end)
-    {
+    key_table_put(table, item_key_hash(item), item);
+}
+
+/* Keep the key table up to date when item is unlinked from object. */
+static void key_table_remove(cJSON * const object, const cJSON * const item)
+{
+    cJSON_KeyTable *table = object->keys;
+    size_t position = 0;
+    size_t next = 0;
+
+    if ((table == NULL) || (item->string == NULL))
+    {
+        return;
+    }
+
+    position = item_key_hash(item) & table->mask;
+    while (table->slots[position].item != item)
+    {
+        if (table->slots[position].item == NULL)
+        {
+            return; /* not in the table */
+        }
+        position = (position + 1) & table->mask;
+    }
+
+    /* move later entries of the probe sequence into the gap, so no tombstones are needed */
+    next = position;
+    for (;;)
+    {
+        size_t home = 0;
+
+        next = (next + 1) & table->mask;
+        if (table->slots[next].item == NULL)
+        {
+            break;
+        }
+        home = table->slots[next].hash & table->mask;
+        /* entries whose home is cyclically in (position, next] have to stay */
+        if ((position <= next) ? ((position < home) && (home <= next)) : ((position < home) || (home <= next)))
+        {
+            continue;
+        }
+        table->slots[position] = table->slots[next];
+        position = next;
+    }
+    table->slots[position].item = NULL;
+    table->count--;
+}
+
+/* Build the key table of an object that is being looked up, e.g. by several readers at once. */
+static const cJSON_KeyTable *key_table_build_lazily(const cJSON * const object)
+{
+    cJSON_KeyTable *expected = NULL;
+    cJSON_KeyTable *table = NULL;
+
+    /* arena items can't own heap memory, references share their children with the original */
+    if ((object->type & (cJSON_InArena | cJSON_IsReference)) || ((object->type & 0xFF) != cJSON_Object))
+    {
+        return NULL;
+    }
+
+    table = key_table_create(object, &global_hooks);
+    if (table == NULL)
+    {
+        return NULL;
+    }
+
+#if defined (__clang__) || ((__GNUC__)  && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ > 5))))
+    #pragma GCC diagnostic push
+#endif
+#ifdef __GNUC__
+#pragma GCC diagnostic ignored "-Wcast-qual"
+#endif
+    if (!publish_key_table((cJSON*)object, expected, table))
+    {
+        /* somebody else was faster */
+        global_hooks.deallocate(table);
+        return expected;
+    }
+#if defined (__clang__) || ((__GNUC__)  && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ > 5))))
+    #pragma GCC diagnostic pop
+#endif
+
+    return table;
+}
+
+/* Children that several arrays or objects share, see cJSON_Fork. The number of items using
+ * them is allocated on its own, so the children stay where they are, and the items point to
+ * it with valuestring, which arrays and objects don't use otherwise. */
+typedef struct
+{
+    size_t references;
+} shared_children;
+
+#define shared_children_of(item) ((shared_children*)(void*)(item)->valuestring)
+
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE)
+#define shared_children_retain(shared) ((void)__atomic_add_fetch(&(shared)->references, 1, __ATOMIC_RELAXED))
+#define shared_children_drop(shared) (__atomic_sub_fetch(&(shared)->references, 1, __ATOMIC_ACQ_REL) == 0)
+#define shared_children_count(shared) (__atomic_load_n(&(shared)->references, __ATOMIC_ACQUIRE))
+#else
+#define shared_children_retain(shared) ((void)(shared)->references++)
+#define shared_children_drop(shared) (--(shared)->references == 0)
+#define shared_children_count(shared) ((shared)->references)
+#endif
+
+static void delete_item(cJSON *item, const internal_hooks * const hooks);
+
+/* Drop one reference to the shared children starting at first, the last one deletes them. */
+static void release_shared_children(cJSON * const first, shared_children * const shared, const internal_hooks * const hooks)
+{
+    if (shared_children_drop(shared))
+    {
+        delete_item(first, hooks);
+        hooks->deallocate(shared);
+    }
+}
+
+/* Free everything an item owns, but not the item itself. */
+static void release_item(cJSON * const item, const internal_hooks * const hooks)
+{
+    if (item->type & cJSON_ChildIsShared)
+    {
+        release_shared_children(item->child, shared_children_of(item), hooks);
+    }
+    else if (!(item->type & cJSON_IsReference) && (item->child != NULL))
+    {
+        delete_item(item->child, hooks);
+    }
+    if (!(item->type & cJSON_IsReference))
+    {
+        index_free(item);
+        key_table_free(item);
+    }
+    if (!(item->type & (cJSON_IsReference | cJSON_InSitu | cJSON_ChildIsShared)) && (item->valuestring != NULL))
+    {
+        hooks->deallocate(item->valuestring);
+    }
+    release_key(item, hooks);
+}
+
+/* Delete a cJSON structure whose items were allocated with hooks. */
+static void delete_item(cJSON *item, const internal_hooks * const hooks)
+{
+    cJSON *next = NULL;
+    while (item != NULL)
+    {
+        next = item->next;
+        if (item->type & cJSON_InArena)
+        {
+            /* released together with its arena */
+            item = next;
+            continue;
+        }
+        release_item(item, hooks);
+        hooks->deallocate(item);
+        item = next;
+    }
+}
+
+CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
+{
+    if ((item != NULL) && (item->type & cJSON_IsSharedChild))
+    {
+        /* still belongs to the shared children, see cJSON_Fork */
+        return;
+    }
+    delete_item(item, &global_hooks);
+}
+
+/* get the decimal point character of the current locale */
+static unsigned char get_decimal_point(void)
+{
+    struct lconv *lconv = localeconv();
+    return (unsigned char) lconv->decimal_point[0];
+}
+
+typedef struct
+{
+    const unsigned char *content;
+    size_t length;
+    size_t offset;
+    size_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset. */
+    internal_hooks hooks;
+    int flags; /* cJSON_Parse... option flags */
+    unsigned char *in_situ; /* the input itself if strings are unescaped in place, see cJSON_ParseInSitu */
+    struct key_pool *keys; /* the keys parsed so far, if they are shared (see cJSON_ParseInternKeys) */
+    size_t nesting_limit; /* how deeply arrays/objects may be nested */
+} parse_buffer;
+
+/* Indexes and key tables are freed, and rebuilt lazily, with the global hooks, so
+ * parsing allocates them with those too unless they go into an arena. */
+#define table_hooks(buffer) (((buffer)->hooks.arena != NULL) ? &(buffer)->hooks : &global_hooks)
+
+/* check if the given size is left to read in a given parse buffer (starting with 1) */
+#define can_read(buffer, size) ((buffer != NULL) && (((buffer)->offset + size) <= (buffer)->length))
+//#define cannot_read(buffer, size) (!can_read(buffer, size))
+/* check if the buffer can be accessed at the given index (starting with 0) */
+#define can_access_at_index(buffer, index) ((buffer != NULL) && (((buffer)->offset + index) < (buffer)->length))
+#define cannot_access_at_index(buffer, index) (!can_access_at_index(buffer, index))
+/* get a pointer to the buffer at the position */
+#define buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
+/* set the type of an item, keeping the flags that tell where its memory comes from */
+#define set_item_type(item, new_type) ((item)->type = (new_type) | ((item)->type & (cJSON_InArena | cJSON_InSitu | cJSON_StringIsConst | cJSON_KeyIsShared)))
+
+/* Number conversion without libc: parse_number and print_number handle the
+ * common cases with integer arithmetic and only fall back to strtod (which
+ * depends on the locale and is slow) for the rest. */
+
+/* 64x64 -> 128 bit multiplication, returns the high half */
+static uint64_t multiply_64(const uint64_t a, const uint64_t b, uint64_t * const low)
+{
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 uint128;
+    uint128 product = (uint128)a * b;
+    *low = (uint64_t)product;
+    return (uint64_t)(product >> 64);
+#else
+    uint64_t a_low = a & 0xFFFFFFFF;
+    uint64_t a_high = a >> 32;
+    uint64_t b_low = b & 0xFFFFFFFF;
+    uint64_t b_high = b >> 32;
+    uint64_t low_low = a_low * b_low;
+    uint64_t high_low = a_high * b_low;
+    uint64_t cross = (low_low >> 32) + (high_low & 0xFFFFFFFF) + (a_low * b_high);
+    *low = (cross << 32) | (low_low & 0xFFFFFFFF);
+    return (high_low >> 32) + (cross >> 32) + (a_high * b_high);
+#endif
+}
+
+static int leading_zeros_64(uint64_t value)
+{
+#if defined(__GNUC__)
+    return __builtin_clzll(value);
+#else
+    int count = 0;
+    while (!(value & ((uint64_t)1 << 63)))
+    {
+        value <<= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+/* powers of ten that a double holds exactly */
+static const double exact_powers_of_ten[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* 5^q as 128 bit fractions with the most significant bit set, for q in
+ * [POWER_OF_FIVE_MIN, POWER_OF_FIVE_MAX]. That covers the exponents that show
+ * up in practice, numbers outside of it are left to strtod. */
+#define POWER_OF_FIVE_MIN (-64)
+#define POWER_OF_FIVE_MAX 64
+static const struct
+{
+    uint64_t high;
+    uint64_t low;
+} powers_of_five[] =
+{
+    {0xa87fea27a539e9a5ULL, 0x3f2398d747b36224ULL}, /* 5^-64 */
+    {0xd29fe4b18e88640eULL, 0x8eec7f0d19a03aadULL}, /* 5^-63 */
+    {0x83a3eeeef9153e89ULL, 0x1953cf68300424acULL}, /* 5^-62 */
+    {0xa48ceaaab75a8e2bULL, 0x5fa8c3423c052dd7ULL}, /* 5^-61 */
+    {0xcdb02555653131b6ULL, 0x3792f412cb06794dULL}, /* 5^-60 */
+    {0x808e17555f3ebf11ULL, 0xe2bbd88bbee40bd0ULL}, /* 5^-59 */
+    {0xa0b19d2ab70e6ed6ULL, 0x5b6aceaeae9d0ec4ULL}, /* 5^-58 */
+    {0xc8de047564d20a8bULL, 0xf245825a5a445275ULL}, /* 5^-57 */
+    {0xfb158592be068d2eULL, 0xeed6e2f0f0d56712ULL}, /* 5^-56 */
+    {0x9ced737bb6c4183dULL, 0x55464dd69685606bULL}, /* 5^-55 */
+    {0xc428d05aa4751e4cULL, 0xaa97e14c3c26b886ULL}, /* 5^-54 */
+    {0xf53304714d9265dfULL, 0xd53dd99f4b3066a8ULL}, /* 5^-53 */
+    {0x993fe2c6d07b7fabULL, 0xe546a8038efe4029ULL}, /* 5^-52 */
+    {0xbf8fdb78849a5f96ULL, 0xde98520472bdd033ULL}, /* 5^-51 */
+    {0xef73d256a5c0f77cULL, 0x963e66858f6d4440ULL}, /* 5^-50 */
+    {0x95a8637627989aadULL, 0xdde7001379a44aa8ULL}, /* 5^-49 */
+    {0xbb127c53b17ec159ULL, 0x5560c018580d5d52ULL}, /* 5^-48 */
+    {0xe9d71b689dde71afULL, 0xaab8f01e6e10b4a6ULL}, /* 5^-47 */
+    {0x9226712162ab070dULL, 0xcab3961304ca70e8ULL}, /* 5^-46 */
+    {0xb6b00d69bb55c8d1ULL, 0x3d607b97c5fd0d22ULL}, /* 5^-45 */
+    {0xe45c10c42a2b3b05ULL, 0x8cb89a7db77c506aULL}, /* 5^-44 */
+    {0x8eb98a7a9a5b04e3ULL, 0x77f3608e92adb242ULL}, /* 5^-43 */
+    {0xb267ed1940f1c61cULL, 0x55f038b237591ed3ULL}, /* 5^-42 */
+    {0xdf01e85f912e37a3ULL, 0x6b6c46dec52f6688ULL}, /* 5^-41 */
+    {0x8b61313bbabce2c6ULL, 0x2323ac4b3b3da015ULL}, /* 5^-40 */
+    {0xae397d8aa96c1b77ULL, 0xabec975e0a0d081aULL}, /* 5^-39 */
+    {0xd9c7dced53c72255ULL, 0x96e7bd358c904a21ULL}, /* 5^-38 */
+    {0x881cea14545c7575ULL, 0x7e50d64177da2e54ULL}, /* 5^-37 */
+    {0xaa242499697392d2ULL, 0xdde50bd1d5d0b9e9ULL}, /* 5^-36 */
+    {0xd4ad2dbfc3d07787ULL, 0x955e4ec64b44e864ULL}, /* 5^-35 */
+    {0x84ec3c97da624ab4ULL, 0xbd5af13bef0b113eULL}, /* 5^-34 */
+    {0xa6274bbdd0fadd61ULL, 0xecb1ad8aeacdd58eULL}, /* 5^-33 */
+    {0xcfb11ead453994baULL, 0x67de18eda5814af2ULL}, /* 5^-32 */
+    {0x81ceb32c4b43fcf4ULL, 0x80eacf948770ced7ULL}, /* 5^-31 */
+    {0xa2425ff75e14fc31ULL, 0xa1258379a94d028dULL}, /* 5^-30 */
+    {0xcad2f7f5359a3b3eULL, 0x096ee45813a04330ULL}, /* 5^-29 */
+    {0xfd87b5f28300ca0dULL, 0x8bca9d6e188853fcULL}, /* 5^-28 */
+    {0x9e74d1b791e07e48ULL, 0x775ea264cf55347eULL}, /* 5^-27 */
+    {0xc612062576589ddaULL, 0x95364afe032a819eULL}, /* 5^-26 */
+    {0xf79687aed3eec551ULL, 0x3a83ddbd83f52205ULL}, /* 5^-25 */
+    {0x9abe14cd44753b52ULL, 0xc4926a9672793543ULL}, /* 5^-24 */
+    {0xc16d9a0095928a27ULL, 0x75b7053c0f178294ULL}, /* 5^-23 */
+    {0xf1c90080baf72cb1ULL, 0x5324c68b12dd6339ULL}, /* 5^-22 */
+    {0x971da05074da7beeULL, 0xd3f6fc16ebca5e04ULL}, /* 5^-21 */
+    {0xbce5086492111aeaULL, 0x88f4bb1ca6bcf585ULL}, /* 5^-20 */
+    {0xec1e4a7db69561a5ULL, 0x2b31e9e3d06c32e6ULL}, /* 5^-19 */
+    {0x9392ee8e921d5d07ULL, 0x3aff322e62439fd0ULL}, /* 5^-18 */
+    {0xb877aa3236a4b449ULL, 0x09befeb9fad487c3ULL}, /* 5^-17 */
+    {0xe69594bec44de15bULL, 0x4c2ebe687989a9b4ULL}, /* 5^-16 */
+    {0x901d7cf73ab0acd9ULL, 0x0f9d37014bf60a11ULL}, /* 5^-15 */
+    {0xb424dc35095cd80fULL, 0x538484c19ef38c95ULL}, /* 5^-14 */
+    {0xe12e13424bb40e13ULL, 0x2865a5f206b06fbaULL}, /* 5^-13 */
+    {0x8cbccc096f5088cbULL, 0xf93f87b7442e45d4ULL}, /* 5^-12 */
+    {0xafebff0bcb24aafeULL, 0xf78f69a51539d749ULL}, /* 5^-11 */
+    {0xdbe6fecebdedd5beULL, 0xb573440e5a884d1cULL}, /* 5^-10 */
+    {0x89705f4136b4a597ULL, 0x31680a88f8953031ULL}, /* 5^-9 */
+    {0xabcc77118461cefcULL, 0xfdc20d2b36ba7c3eULL}, /* 5^-8 */
+    {0xd6bf94d5e57a42bcULL, 0x3d32907604691b4dULL}, /* 5^-7 */
+    {0x8637bd05af6c69b5ULL, 0xa63f9a49c2c1b110ULL}, /* 5^-6 */
+    {0xa7c5ac471b478423ULL, 0x0fcf80dc33721d54ULL}, /* 5^-5 */
+    {0xd1b71758e219652bULL, 0xd3c36113404ea4a9ULL}, /* 5^-4 */
+    {0x83126e978d4fdf3bULL, 0x645a1cac083126eaULL}, /* 5^-3 */
+    {0xa3d70a3d70a3d70aULL, 0x3d70a3d70a3d70a4ULL}, /* 5^-2 */
+    {0xccccccccccccccccULL, 0xcccccccccccccccdULL}, /* 5^-1 */
+    {0x8000000000000000ULL, 0x0000000000000000ULL}, /* 5^0 */
+    {0xa000000000000000ULL, 0x0000000000000000ULL}, /* 5^1 */
+    {0xc800000000000000ULL, 0x0000000000000000ULL}, /* 5^2 */
+    {0xfa00000000000000ULL, 0x0000000000000000ULL}, /* 5^3 */
+    {0x9c40000000000000ULL, 0x0000000000000000ULL}, /* 5^4 */
+    {0xc350000000000000ULL, 0x0000000000000000ULL}, /* 5^5 */
+    {0xf424000000000000ULL, 0x0000000000000000ULL}, /* 5^6 */
+    {0x9896800000000000ULL, 0x0000000000000000ULL}, /* 5^7 */
+    {0xbebc200000000000ULL, 0x0000000000000000ULL}, /* 5^8 */
+    {0xee6b280000000000ULL, 0x0000000000000000ULL}, /* 5^9 */
+    {0x9502f90000000000ULL, 0x0000000000000000ULL}, /* 5^10 */
+    {0xba43b74000000000ULL, 0x0000000000000000ULL}, /* 5^11 */
+    {0xe8d4a51000000000ULL, 0x0000000000000000ULL}, /* 5^12 */
+    {0x9184e72a00000000ULL, 0x0000000000000000ULL}, /* 5^13 */
+    {0xb5e620f480000000ULL, 0x0000000000000000ULL}, /* 5^14 */
+    {0xe35fa931a0000000ULL, 0x0000000000000000ULL}, /* 5^15 */
+    {0x8e1bc9bf04000000ULL, 0x0000000000000000ULL}, /* 5^16 */
+    {0xb1a2bc2ec5000000ULL, 0x0000000000000000ULL}, /* 5^17 */
+    {0xde0b6b3a76400000ULL, 0x0000000000000000ULL}, /* 5^18 */
+    {0x8ac7230489e80000ULL, 0x0000000000000000ULL}, /* 5^19 */
+    {0xad78ebc5ac620000ULL, 0x0000000000000000ULL}, /* 5^20 */
+    {0xd8d726b7177a8000ULL, 0x0000000000000000ULL}, /* 5^21 */
+    {0x878678326eac9000ULL, 0x0000000000000000ULL}, /* 5^22 */
+    {0xa968163f0a57b400ULL, 0x0000000000000000ULL}, /* 5^23 */
+    {0xd3c21bcecceda100ULL, 0x0000000000000000ULL}, /* 5^24 */
+    {0x84595161401484a0ULL, 0x0000000000000000ULL}, /* 5^25 */
+    {0xa56fa5b99019a5c8ULL, 0x0000000000000000ULL}, /* 5^26 */
+    {0xcecb8f27f4200f3aULL, 0x0000000000000000ULL}, /* 5^27 */
+    {0x813f3978f8940984ULL, 0x4000000000000000ULL}, /* 5^28 */
+    {0xa18f07d736b90be5ULL, 0x5000000000000000ULL}, /* 5^29 */
+    {0xc9f2c9cd04674edeULL, 0xa400000000000000ULL}, /* 5^30 */
+    {0xfc6f7c4045812296ULL, 0x4d00000000000000ULL}, /* 5^31 */
+    {0x9dc5ada82b70b59dULL, 0xf020000000000000ULL}, /* 5^32 */
+    {0xc5371912364ce305ULL, 0x6c28000000000000ULL}, /* 5^33 */
+    {0xf684df56c3e01bc6ULL, 0xc732000000000000ULL}, /* 5^34 */
+    {0x9a130b963a6c115cULL, 0x3c7f400000000000ULL}, /* 5^35 */
+    {0xc097ce7bc90715b3ULL, 0x4b9f100000000000ULL}, /* 5^36 */
+    {0xf0bdc21abb48db20ULL, 0x1e86d40000000000ULL}, /* 5^37 */
+    {0x96769950b50d88f4ULL, 0x1314448000000000ULL}, /* 5^38 */
+    {0xbc143fa4e250eb31ULL, 0x17d955a000000000ULL}, /* 5^39 */
+    {0xeb194f8e1ae525fdULL, 0x5dcfab0800000000ULL}, /* 5^40 */
+    {0x92efd1b8d0cf37beULL, 0x5aa1cae500000000ULL}, /* 5^41 */
+    {0xb7abc627050305adULL, 0xf14a3d9e40000000ULL}, /* 5^42 */
+    {0xe596b7b0c643c719ULL, 0x6d9ccd05d0000000ULL}, /* 5^43 */
+    {0x8f7e32ce7bea5c6fULL, 0xe4820023a2000000ULL}, /* 5^44 */
+    {0xb35dbf821ae4f38bULL, 0xdda2802c8a800000ULL}, /* 5^45 */
+    {0xe0352f62a19e306eULL, 0xd50b2037ad200000ULL}, /* 5^46 */
+    {0x8c213d9da502de45ULL, 0x4526f422cc340000ULL}, /* 5^47 */
+    {0xaf298d050e4395d6ULL, 0x9670b12b7f410000ULL}, /* 5^48 */
+    {0xdaf3f04651d47b4cULL, 0x3c0cdd765f114000ULL}, /* 5^49 */
+    {0x88d8762bf324cd0fULL, 0xa5880a69fb6ac800ULL}, /* 5^50 */
+    {0xab0e93b6efee0053ULL, 0x8eea0d047a457a00ULL}, /* 5^51 */
+    {0xd5d238a4abe98068ULL, 0x72a4904598d6d880ULL}, /* 5^52 */
+    {0x85a36366eb71f041ULL, 0x47a6da2b7f864750ULL}, /* 5^53 */
+    {0xa70c3c40a64e6c51ULL, 0x999090b65f67d924ULL}, /* 5^54 */
+    {0xd0cf4b50cfe20765ULL, 0xfff4b4e3f741cf6dULL}, /* 5^55 */
+    {0x82818f1281ed449fULL, 0xbff8f10e7a8921a4ULL}, /* 5^56 */
+    {0xa321f2d7226895c7ULL, 0xaff72d52192b6a0dULL}, /* 5^57 */
+    {0xcbea6f8ceb02bb39ULL, 0x9bf4f8a69f764490ULL}, /* 5^58 */
+    {0xfee50b7025c36a08ULL, 0x02f236d04753d5b4ULL}, /* 5^59 */
+    {0x9f4f2726179a2245ULL, 0x01d762422c946590ULL}, /* 5^60 */
+    {0xc722f0ef9d80aad6ULL, 0x424d3ad2b7b97ef5ULL}, /* 5^61 */
+    {0xf8ebad2b84e0d58bULL, 0xd2e0898765a7deb2ULL}, /* 5^62 */
+    {0x9b934c3b330c8577ULL, 0x63cc55f49f88eb2fULL}, /* 5^63 */
+    {0xc2781f49ffcfa6d5ULL, 0x3cbf6b71c76b25fbULL} /* 5^64 */
+};
+
+/* Compute the double closest to mantissa * 10^exponent with the Eisel-Lemire
+ * algorithm. Returns false for the rare cases it can't decide, those have to
+ * go through strtod. */
+static cJSON_bool decimal_to_double(uint64_t mantissa, const int exponent, const cJSON_bool negative, double * const number)
+{
+    uint64_t upper = 0;
+    uint64_t lower = 0;
+    uint64_t bits = 0;
+    int64_t binary_exponent = 0;
+    int zeros = 0;
+    int upper_bit = 0;
+
+    if (mantissa == 0)
+    {
+        *number = negative ? -0.0 : 0.0;
+        return true;
+    }
+
+#if defined(FLT_EVAL_METHOD) && (FLT_EVAL_METHOD == 0)
+    /* both operands are exact, so is the correctly rounded result (Clinger's fast path) */
+    if ((mantissa <= ((uint64_t)1 << 53)) && (exponent >= -22) && (exponent <= 22))
+    {
+        double value = (double)mantissa;
+        value = (exponent < 0) ? (value / exact_powers_of_ten[-exponent]) : (value * exact_powers_of_ten[exponent]);
+        *number = negative ? -value : value;
+        return true;
+    }
+#endif
+
+    if ((exponent < POWER_OF_FIVE_MIN) || (exponent > POWER_OF_FIVE_MAX))
+    {
+        return false;
+    }
+
+    zeros = leading_zeros_64(mantissa);
+    mantissa <<= zeros;
+    upper = multiply_64(mantissa, powers_of_five[exponent - POWER_OF_FIVE_MIN].high, &lower);
+    if (((upper & 0x1FF) == 0x1FF) && ((lower + mantissa) < lower))
+    {
+        /* the truncated product might be off by one in the last bit, use the rest of the power too */
+        uint64_t product_low = 0;
+        uint64_t product_middle = multiply_64(mantissa, powers_of_five[exponent - POWER_OF_FIVE_MIN].low, &product_low);
+        product_middle += lower;
+        if (product_middle < lower)
+        {
+            upper++;
+        }
+        if (((product_middle + 1) == 0) && ((upper & 0x1FF) == 0x1FF) && ((product_low + mantissa) < product_low))
+        {
+            return false;
+        }
+        lower = product_middle;
+    }
+
+    upper_bit = (int)(upper >> 63);
+    bits = upper >> (upper_bit + 9);
+    zeros += 1 ^ upper_bit;
+    if ((lower == 0) && ((upper & 0x1FF) == 0) && ((bits & 3) == 1))
+    {
+        return false; /* exactly halfway between two doubles, strtod knows how to round it */
+    }
+
+    /* round to 53 bits */
+    bits += bits & 1;
+    bits >>= 1;
+    if (bits >= ((uint64_t)1 << 53))
+    {
+        bits = (uint64_t)1 << 52;
+        zeros--;
+    }
+    bits &= ~((uint64_t)1 << 52);
+
+    /* floor(exponent * log2(10)) + 1024 + 63 - zeros, the shift is done by hand to avoid shifting negative numbers */
+    binary_exponent = (int64_t)(152170 + 65536) * exponent;
+    binary_exponent = (binary_exponent >= 0) ? (binary_exponent / 65536) : -((-binary_exponent + 65535) / 65536);
+    binary_exponent += 1024 + 63 - zeros;
+    if ((binary_exponent < 1) || (binary_exponent > 2046))
+    {
+        return false; /* subnormal or out of range */
+    }
+
+    bits |= (uint64_t)binary_exponent << 52;
+    if (negative)
+    {
+        bits |= (uint64_t)1 << 63;
+    }
+    memcpy(number, &bits, sizeof(*number));
+
+    return true;
+}
+
+/* Parse a number without strtod. Returns false if it has to be left to parse_number_strtod.
+ * Accepts the same syntax as strtod does for input that starts with '-' or a digit. */
+static cJSON_bool parse_number_fast(const parse_buffer * const input_buffer, double * const number, size_t * const length)
+{
+    const unsigned char *input = buffer_at_offset(input_buffer);
+    size_t available = input_buffer->length - input_buffer->offset;
+    size_t i = 0;
+    uint64_t mantissa = 0;
+    int significant_digits = 0;
+    int exponent = 0;
+    cJSON_bool negative = false;
+    cJSON_bool has_digits = false;
+
+    if ((available > 0) && (input[0] == '-'))
+    {
+        negative = true;
+        i++;
+    }
+
+    /* integer part */
+    for (; (i < available) && (input[i] >= '0') && (input[i] <= '9'); i++)
+    {
+        has_digits = true;
+        if ((mantissa == 0) && (input[i] == '0'))
+        {
+            continue; /* leading zero */
+        }
+        if (significant_digits == 19)
+        {
+            return false; /* doesn't fit into 64 bits */
+        }
+        mantissa = (mantissa * 10) + (uint64_t)(input[i] - '0');
+        significant_digits++;
+    }
+
+    /* fraction */
+    if ((i < available) && (input[i] == '.'))
+    {
+        for (i++; (i < available) && (input[i] >= '0') && (input[i] <= '9'); i++)
+        {
+            has_digits = true;
+            exponent--;
+            if ((mantissa == 0) && (input[i] == '0'))
+            {
+                continue;
+            }
+            if (significant_digits == 19)
+            {
+                return false;
+            }
+            mantissa = (mantissa * 10) + (uint64_t)(input[i] - '0');
+            significant_digits++;
+        }
+    }
+
+    if (!has_digits)
+    {
+        return false;
+    }
+
+    /* exponent, only if there are digits after the 'e' and its sign */
+    if ((i < available) && ((input[i] == 'e') || (input[i] == 'E')))
+    {
+        size_t j = i + 1;
+        cJSON_bool negative_exponent = false;
+        int exponent_value = 0;
+
+        if ((j < available) && ((input[j] == '+') || (input[j] == '-')))
+        {
+            negative_exponent = (input[j] == '-');
+            j++;
+        }
+        if ((j < available) && (input[j] >= '0') && (input[j] <= '9'))
+        {
+            for (; (j < available) && (input[j] >= '0') && (input[j] <= '9'); j++)
+            {
+                /* saturate, anything this big over- or underflows anyway */
+                if (exponent_value < 100000)
+                {
+                    exponent_value = (exponent_value * 10) + (input[j] - '0');
+                }
+            }
+            exponent += negative_exponent ? -exponent_value : exponent_value;
+            i = j;
+        }
+    }
+
+    /* parse_number_strtod only looks at the first 63 characters */
+    if (i > 63)
+    {
+        return false;
+    }
+
+    if (!decimal_to_double(mantissa, exponent, negative, number))
+    {
+        return false;
+    }
+    *length = i;
+
+    return true;
+}
+
+/* Parse a number with strtod. */
+static cJSON_bool parse_number_strtod(const parse_buffer * const input_buffer, double * const number, size_t * const length)
+{
+    unsigned char *after_end = NULL;
+    unsigned char number_c_string[64];
+    unsigned char decimal_point = get_decimal_point();
+    size_t i = 0;
+
+    /* copy the number into a temporary buffer and replace '.' with the decimal point
+     * of the current locale (for strtod)
+     * This also takes care of '\0' not necessarily being available for marking the end of the input */
+    for (i = 0; (i < (sizeof(number_c_string) - 1)) && can_access_at_index(input_buffer, i); i++)
+    {
+        switch (buffer_at_offset(input_buffer)[i])
+        {
+            case '0':
+            case '1':
+            case '2':
+            case '3':
+            case '4':
+            case '5':
+            case '6':
+            case '7':
+            case '8':
+            case '9':
+            case '+':
+            case '-':
+            case 'e':
+            case 'E':
+                number_c_string[i] = buffer_at_offset(input_buffer)[i];
+                break;
+
+            case '.':
+                number_c_string[i] = decimal_point;
+                break;
+
+            default:
+                goto loop_end;
+        }
+    }
+loop_end:
+    number_c_string[i] = '\0';
+
+    *number = strtod((const char*)number_c_string, (char**)&after_end);
+    if (number_c_string == after_end)
+    {
+        return false; /* parse_error */
+    }
+    *length = (size_t)(after_end - number_c_string);
+
+    return true;
+}
+
+/* Parse the input text to generate a number, and populate the result into item. */
+static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
+{
+    double number = 0;
+    size_t length = 0;
+
+    if ((input_buffer == NULL) || (input_buffer->content == NULL))
+    {
+        return false;
+    }
+
+    if (!parse_number_fast(input_buffer, &number, &length) && !parse_number_strtod(input_buffer, &number, &length))
+    {
+        return false;
+    }
+
+    item->valuedouble = number;
+
+    /* use saturation in case of overflow */
+    if (number >= INT_MAX)
+    {
+        item->valueint = INT_MAX;
+    }
+    else if (number <= INT_MIN)
+    {
+        item->valueint = INT_MIN;
+    }
+    else
+    {
+        item->valueint = (int)number;
+    }
+
+    set_item_type(item, cJSON_Number);
+
+    input_buffer->offset += length;
+    return true;
+}
+
+/* don't ask me, but the original cJSON_SetNumberValue returns an integer or double */
+CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number)
+{
+    if (object->type & cJSON_IsSharedChild)
+    {
+        /* read only, see cJSON_Fork */
+        return object->valuedouble;
+    }
+
+    if (number >= INT_MAX)
+    {
+        object->valueint = INT_MAX;
+    }
+    else if (number <= INT_MIN)
+    {
+        object->valueint = INT_MIN;
+    }
+    else
+    {
+        object->valueint = (int)number;
+    }
+
+    return object->valuedouble = number;
+}
+
+typedef struct
+{
+    unsigned char *buffer;
+    size_t length;
+    size_t offset;
+    size_t depth; /* current nesting depth (for formatted printing) */
+    cJSON_bool noalloc;
+    cJSON_bool format; /* is this print a formatted print */
+    internal_hooks hooks;
+    cJSON_PrintSink sink; /* if set, the buffer is handed to it whenever it is full and then reused */
+    void *sink_context;
+} printbuffer;
+
+/* realloc printbuffer if necessary to have at least "needed" bytes more, plus one for the terminating '\0' */
+static unsigned char* ensure(printbuffer * const p, size_t needed)
+{
+    unsigned char *newbuffer = NULL;
+    size_t newsize = 0;
+
+    if ((p == NULL) || (p->buffer == NULL))
+    {
+        return NULL;
+    }
+
+    if ((p->length > 0) && (p->offset >= p->length))
+    {
+        /* make sure that offset is valid */
+        return NULL;
+    }
+
+    if (needed > INT_MAX)
+    {
+        /* sizes bigger than INT_MAX are currently not supported */
+        return NULL;
+    }
+
+    needed += p->offset + 1;
+    if (needed <= p->length)
+    {
+        return p->buffer + p->offset;
+    }
+
+    if ((p->sink != NULL) && (p->offset > 0))
+    {
+        /* hand over what was printed so far and start over at the beginning of the buffer */
+        if (!p->sink(p->sink_context, (const char*)p->buffer, p->offset))
+        {
+            return NULL;
+        }
+        needed -= p->offset;
+        p->offset = 0;
+        if (needed <= p->length)
+        {
+            return p->buffer;
+        }
+    }
+
+    if (p->noalloc) {
+        return NULL;
+    }
+
+    /* calculate new buffer size */
+    if (needed > (INT_MAX / 2))
+    {
+        /* overflow of int, use INT_MAX if possible */
+        if (needed <= INT_MAX)
+        {
+            newsize = INT_MAX;
+        }
+        else
+        {
+            return NULL;
+        }
+    }
+    else
+    {
+        newsize = needed * 2;
+    }
+
+    if (p->hooks.reallocate != NULL)
+    {
+        /* reallocate with realloc if available */
+        newbuffer = (unsigned char*)p->hooks.reallocate(p->buffer, newsize);
+    }
+    else
+    {
+        /* otherwise reallocate manually */
+        newbuffer = (unsigned char*)p->hooks.allocate(newsize);
+        if (!newbuffer)
+        {
+            p->hooks.deallocate(p->buffer);
+            p->length = 0;
+            p->buffer = NULL;
+
+            return NULL;
+        }
+        if (newbuffer)
+        {
+            memcpy(newbuffer, p->buffer, p->offset + 1);
+        }
+        p->hooks.deallocate(p->buffer);
+    }
+    p->length = newsize;
+    p->buffer = newbuffer;
+
+    return newbuffer + p->offset;
+}
+
+/* A floating point number with a 64 bit significand: f * 2^e */
+typedef struct
+{
+    uint64_t f;
+    int e;
+} diy_fp;
+
+/* 10^k for k = -348, -340, ..., 340 as diy_fp, rounded to 64 bits */
+static const uint64_t cached_powers_f[] =
+{
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL, 0xcf42894a5dce35eaULL,
+    0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL, 0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL,
+    0xbe5691ef416bd60cULL, 0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL, 0xc21094364dfb5637ULL,
+    0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL, 0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL,
+    0xb23867fb2a35b28eULL, 0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL, 0xb5b5ada8aaff80b8ULL,
+    0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL, 0x964e858c91ba2655ULL, 0xdff9772470297ebdULL,
+    0xa6dfbd9fb8e5b88fULL, 0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL, 0xaa242499697392d3ULL,
+    0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL, 0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL,
+    0x9c40000000000000ULL, 0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL, 0x9f4f2726179a2245ULL,
+    0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL, 0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL,
+    0x924d692ca61be758ULL, 0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL, 0x952ab45cfa97a0b3ULL,
+    0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL, 0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL,
+    0x88fcf317f22241e2ULL, 0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL, 0x8bab8eefb6409c1aULL,
+    0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL, 0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL,
+    0x80444b5e7aa7cf85ULL, 0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+};
+static const short cached_powers_e[] =
+{
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+    -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+    -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+    -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+    56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+    694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+    1013, 1039, 1066
+};
+
+static const uint64_t powers_of_ten_64[] =
+{
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+    1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+    1000000000000000000ULL, 10000000000000000000ULL
+};
+
+static diy_fp diy_fp_multiply(const diy_fp a, const diy_fp b)
+{
+    diy_fp product;
+    uint64_t low = 0;
+
+    product.f = multiply_64(a.f, b.f, &low);
+    /* round to nearest */
+    if (low & ((uint64_t)1 << 63))
+    {
+        product.f++;
+    }
+    product.e = a.e + b.e + 64;
+
+    return product;
+}
+
+static diy_fp diy_fp_normalize(diy_fp value)
+{
+    int shift = leading_zeros_64(value.f);
+
+    value.f <<= shift;
+    value.e -= shift;
+
+    return value;
+}
+
+/* Get a cached power of ten c = 10^-k so that the binary exponent of a number with exponent e times c lands in [-60, -32]. */
+static diy_fp cached_power(const int e, int * const k)
+{
+    diy_fp power;
+    double dk = ((-61 - e) * 0.30102999566398114) + 347;
+    int index = (int)dk;
+
+    if ((dk - index) > 0.0)
+    {
+        index++;
+    }
+    index = (index >> 3) + 1;
+    *k = -(-348 + (index * 8));
+
+    power.f = cached_powers_f[index];
+    power.e = cached_powers_e[index];
+
+    return power;
+}
+
+/* Move the last digit closer to w if that still lies within the boundaries. */
+static void grisu_round(unsigned char * const digits, const int length, const uint64_t delta, uint64_t rest, const uint64_t ten_kappa, const uint64_t wp_w)
+{
+    while ((rest < wp_w) && ((delta - rest) >= ten_kappa)
+            && (((rest + ten_kappa) < wp_w) || ((wp_w - rest) > (rest + ten_kappa - wp_w))))
+    {
+        digits[length - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+/* Generate the shortest digits of a number between mp - delta and mp, see grisu2. */
+static int generate_digits(const diy_fp w, const diy_fp mp, uint64_t delta, unsigned char * const digits, int * const k)
+{
+    const int shift = -mp.e;
+    const uint64_t one = (uint64_t)1 << shift;
+    const uint64_t wp_w = mp.f - w.f;
+    uint32_t integral = (uint32_t)(mp.f >> shift);
+    uint64_t fraction = mp.f & (one - 1);
+    int kappa = 1;
+    int length = 0;
+
+    while ((kappa < 10) && (integral >= powers_of_ten_64[kappa]))
+    {
+        kappa++;
+    }
+
+    while (kappa > 0)
+    {
+        uint32_t divisor = (uint32_t)powers_of_ten_64[kappa - 1];
+        uint32_t digit = integral / divisor;
+        uint64_t rest = 0;
+
+        integral %= divisor;
+        if ((digit != 0) || (length != 0))
+        {
+            digits[length++] = (unsigned char)('0' + digit);
+        }
+        kappa--;
+
+        rest = ((uint64_t)integral << shift) + fraction;
+        if (rest <= delta)
+        {
+            *k += kappa;
+            grisu_round(digits, length, delta, rest, powers_of_ten_64[kappa] << shift, wp_w);
+            return length;
+        }
+    }
+
+    for (;;)
+    {
+        unsigned char digit = 0;
+
+        fraction *= 10;
+        delta *= 10;
+        digit = (unsigned char)(fraction >> shift);
+        if ((digit != 0) || (length != 0))
+        {
+            digits[length++] = (unsigned char)('0' + digit);
+        }
+        fraction &= one - 1;
+        kappa--;
+
+        if (fraction < delta)
+        {
+            *k += kappa;
+            grisu_round(digits, length, delta, fraction, one, (-kappa < 20) ? (wp_w * powers_of_ten_64[-kappa]) : 0);
+            return length;
+        }
+    }
+}
+
+/* Florian Loitsch's Grisu2: write the digits of a positive double, so that
+ * digits * 10^k reads back as the same double. The digits are the shortest
+ * ones in almost all cases. Returns the number of digits. */
+static int grisu2(const double number, unsigned char * const digits, int * const k)
+{
+    diy_fp value;
+    diy_fp plus;
+    diy_fp minus;
+    diy_fp power;
+    diy_fp w;
+    uint64_t bits = 0;
+    int biased_exponent = 0;
+
+    memcpy(&bits, &number, sizeof(bits));
+    biased_exponent = (int)((bits >> 52) & 0x7FF);
+    value.f = bits & (((uint64_t)1 << 52) - 1);
+    if (biased_exponent != 0)
+    {
+        value.f += (uint64_t)1 << 52;
+        value.e = biased_exponent - 1075;
+    }
+    else
+    {
+        /* subnormal */
+        value.e = -1074;
+    }
+
+    /* the boundaries are halfway to the neighbouring doubles */
+    plus.f = (value.f << 1) + 1;
+    plus.e = value.e - 1;
+    plus = diy_fp_normalize(plus);
+    if (value.f == ((uint64_t)1 << 52))
+    {
+        /* the lower neighbour is closer at a power of two */
+        minus.f = (value.f << 2) - 1;
+        minus.e = value.e - 2;
+    }
+    else
+    {
+        minus.f = (value.f << 1) - 1;
+        minus.e = value.e - 1;
+    }
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    power = cached_power(plus.e, k);
+    w = diy_fp_multiply(diy_fp_normalize(value), power);
+    plus = diy_fp_multiply(plus, power);
+    minus = diy_fp_multiply(minus, power);
+    /* stay inside the boundaries despite the rounding errors of the multiplication */
+    minus.f++;
+    plus.f--;
+
+    return generate_digits(w, plus, plus.f - minus.f, digits, k);
+}
+
+/* Check if mantissa * 10^exponent reads back as number. */
+static cJSON_bool reads_back_as(const uint64_t mantissa, const int exponent, const double number)
+{
+    double value = 0;
+    unsigned char text[32];
+    unsigned char *text_pointer = text + sizeof(text);
+    uint64_t rest = mantissa;
+    int magnitude = (exponent < 0) ? -exponent : exponent;
+
+    if (decimal_to_double(mantissa, exponent, false, &value))
+    {
+        return value == number;
+    }
+
+    /* "<mantissa>e<exponent>" has no decimal point, so strtod reads it regardless of the locale */
+    *--text_pointer = '\0';
+    do
+    {
+        *--text_pointer = (unsigned char)('0' + (magnitude % 10));
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (exponent < 0)
+    {
+        *--text_pointer = '-';
+    }
+    *--text_pointer = 'e';
+    do
+    {
+        *--text_pointer = (unsigned char)('0' + (rest % 10));
+        rest /= 10;
+    } while (rest != 0);
+
+    return strtod((const char*)text_pointer, NULL) == number;
+}
+
+/* Grisu2 sometimes produces a digit more than needed. Try the closest numbers
+ * with fewer digits and use them if they read back as the same double. */
+static int shorten_digits(const double number, unsigned char * const digits, const int length, int * const k)
+{
+    int shortest = length;
+    int shortest_k = *k;
+    uint64_t shortest_mantissa = 0;
+    int n = 0;
+
+    for (n = length - 1; n > 0; n--)
+    {
+        uint64_t truncated = 0;
+        uint64_t candidate = 0;
+        int i = 0;
+
+        for (i = 0; i < n; i++)
+        {
+            truncated = (truncated * 10) + (uint64_t)(digits[i] - '0');
+        }
+
+        /* the rounded one first, it is closer */
+        candidate = (digits[n] >= '5') ? (truncated + 1) : truncated;
+        if (!reads_back_as(candidate, *k + (length - n), number))
+        {
+            candidate = (candidate == truncated) ? (truncated + 1) : truncated;
+            if (!reads_back_as(candidate, *k + (length - n), number))
+            {
+                /* if no n digit number does, no shorter one does either */
+                break;
+            }
+        }
+        shortest = n;
+        shortest_k = *k + (length - n);
+        shortest_mantissa = candidate;
+    }
+
+    if (shortest == length)
+    {
+        return length;
+    }
+
+    /* rounding up may have carried into a new digit, e.g. 999 -> 1000 */
+    while ((shortest_mantissa % 10) == 0)
+    {
+        shortest_mantissa /= 10;
+        shortest_k++;
+    }
+    for (n = 0; shortest_mantissa != 0; shortest_mantissa /= 10)
+    {
+        digits[n++] = (unsigned char)('0' + (shortest_mantissa % 10));
+    }
+    /* the digits were written backwards */
+    for (shortest = 0; shortest < (n / 2); shortest++)
+    {
+        unsigned char swap = digits[shortest];
+        digits[shortest] = digits[n - 1 - shortest];
+        digits[n - 1 - shortest] = swap;
+    }
+    *k = shortest_k;
+
+    return n;
+}
+
+/* Write number the way printf's "%1.15g" would, with as many digits as
+ * needed to read back the same double (up to 17, like "%1.17g").
+ * output needs room for 25 characters. Returns the length. */
+static int format_number(const double number, unsigned char * const output)
+{
+    unsigned char digits[20];
+    unsigned char *output_pointer = output;
+    double magnitude = number;
+    int length = 0;
+    int k = 0;
+    int exponent = 0;
+    int precision = 0;
+    int i = 0;
+    uint64_t bits = 0;
+
+    /* the sign bit, so -0 is printed as such */
+    memcpy(&bits, &number, sizeof(bits));
+    if (bits >> 63)
+    {
+        *output_pointer++ = '-';
+        magnitude = -number;
+    }
+
+    if ((magnitude < 1e15) && (magnitude == (double)(int64_t)magnitude))
+    {
+        /* integer, also takes care of 0 */
+        uint64_t integer = (uint64_t)magnitude;
+        do
+        {
+            digits[length++] = (unsigned char)('0' + (integer % 10));
+            integer /= 10;
+        } while (integer != 0);
+        while (length > 0)
+        {
+            *output_pointer++ = digits[--length];
+        }
+        *output_pointer = '\0';
+        return (int)(output_pointer - output);
+    }
+
+    length = grisu2(magnitude, digits, &k);
+    while ((length > 1) && (digits[length - 1] == '0'))
+    {
+        length--;
+        k++;
+    }
+    if (length > 15)
+    {
+        length = shorten_digits(magnitude, digits, length, &k);
+    }
+
+    /* same choice between fixed and scientific notation as %g */
+    exponent = length + k - 1;
+    precision = (length <= 15) ? 15 : 17;
+    if ((exponent < -4) || (exponent >= precision))
+    {
+        *output_pointer++ = digits[0];
+        if (length > 1)
+        {
+            *output_pointer++ = '.';
+            memcpy(output_pointer, digits + 1, (size_t)(length - 1));
+            output_pointer += length - 1;
+        }
+        *output_pointer++ = 'e';
+        *output_pointer++ = (exponent < 0) ? '-' : '+';
+        if (exponent < 0)
+        {
+            exponent = -exponent;
+        }
+        if (exponent >= 100)
+        {
+            *output_pointer++ = (unsigned char)('0' + (exponent / 100));
+        }
+        *output_pointer++ = (unsigned char)('0' + ((exponent / 10) % 10));
+        *output_pointer++ = (unsigned char)('0' + (exponent % 10));
+    }
+    else if (k >= 0)
+    {
+        /* integer with trailing zeros */
+        memcpy(output_pointer, digits, (size_t)length);
+        output_pointer += length;
+        for (i = 0; i < k; i++)
+        {
+            *output_pointer++ = '0';
+        }
+    }
+    else if (exponent >= 0)
+    {
+        memcpy(output_pointer, digits, (size_t)(exponent + 1));
+        output_pointer += exponent + 1;
+        *output_pointer++ = '.';
+        memcpy(output_pointer, digits + exponent + 1, (size_t)(length - exponent - 1));
+        output_pointer += length - exponent - 1;
+    }
+    else
+    {
+        *output_pointer++ = '0';
+        *output_pointer++ = '.';
+        for (i = exponent + 1; i < 0; i++)
+        {
+            *output_pointer++ = '0';
+        }
+        memcpy(output_pointer, digits, (size_t)length);
+        output_pointer += length;
+    }
+    *output_pointer = '\0';
+
+    return (int)(output_pointer - output);
+}
+
+/* Render the number nicely from the given item into a string. */
+static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer)
+{
+    unsigned char *output_pointer = NULL;
+    double d = item->valuedouble;
+    int length = 0;
+    unsigned char number_buffer[26]; /* temporary buffer to print the number into */
+
+    if (output_buffer == NULL)
+    {
+        return false;
+    }
+
+    /* This checks for NaN and Infinity */
+    if ((d * 0) != 0)
+    {
+        memcpy(number_buffer, "null", 5);
+        length = 4;
+    }
+    else
+    {
+        length = format_number(d, number_buffer);
+    }
+
+    /* reserve appropriate space in the output */
+    output_pointer = ensure(output_buffer, (size_t)length);
+    if (output_pointer == NULL)
+    {
+        return false;
+    }
+    memcpy(output_pointer, number_buffer, (size_t)length + 1);
+
+    output_buffer->offset += (size_t)length;
+
+    return true;
+}
+
+/* parse 4 digit hexadecimal number */
+static unsigned parse_hex4(const unsigned char * const input)
+{
+    unsigned int h = 0;
+    size_t i = 0;
+
+    for (i = 0; i < 4; i++)
+    {
+        /* parse digit */
+        if ((input[i] >= '0') && (input[i] <= '9'))
+        {
+            h += (unsigned int) input[i] - '0';
+        }
+        else if ((input[i] >= 'A') && (input[i] <= 'F'))
+        {
+            h += (unsigned int) 10 + input[i] - 'A';
+        }
+        else if ((input[i] >= 'a') && (input[i] <= 'f'))
+        {
+            h += (unsigned int) 10 + input[i] - 'a';
+        }
+        else /* invalid */
+        {
+            return 0;
+        }
+
+        if (i < 3)
+        {
+            /* shift left to make place for the next nibble */
+            h = h << 4;
+        }
+    }
+
+    return h;
+}
+
+/* converts a UTF-16 literal to UTF-8
+ * A literal can be one or two sequences of the form \uXXXX */
+static unsigned char utf16_literal_to_utf8(const unsigned char * const input_pointer, const unsigned char * const input_end, unsigned char **output_pointer)
+{
+    long unsigned int codepoint = 0;
+    unsigned int first_code = 0;
+    const unsigned char *first_sequence = input_pointer;
+    unsigned char utf8_length = 0;
+    unsigned char utf8_position = 0;
+    unsigned char sequence_length = 0;
+    unsigned char first_byte_mark = 0;
+
+    if ((input_end - first_sequence) < 6)
+    {
+        /* input ends unexpectedly */
+        goto fail;
+    }
+
+    /* get the first utf16 sequence */
+    first_code = parse_hex4(first_sequence + 2);
+
+    /* check that the code is valid */
+    if (((first_code >= 0xDC00) && (first_code <= 0xDFFF)))
+    {
+        goto fail;
+    }
+
+    /* UTF16 surrogate pair */
+    if ((first_code >= 0xD800) && (first_code <= 0xDBFF))
+    {
+        const unsigned char *second_sequence = first_sequence + 6;
+        unsigned int second_code = 0;
+        sequence_length = 12; /* \uXXXX\uXXXX */
+
+        if ((input_end - second_sequence) < 6)
+        {
+            /* input ends unexpectedly */
+            goto fail;
+        }
+
+        if ((second_sequence[0] != '\\') || (second_sequence[1] != 'u'))
+        {
+            /* missing second half of the surrogate pair */
+            goto fail;
+        }
+
+        /* get the second utf16 sequence */
+        second_code = parse_hex4(second_sequence + 2);
+        /* check that the code is valid */
+        if ((second_code < 0xDC00) || (second_code > 0xDFFF))
+        {
+            /* invalid second half of the surrogate pair */
+            goto fail;
+        }
+
+
+        /* calculate the unicode codepoint from the surrogate pair */
+        codepoint = 0x10000 + (((first_code & 0x3FF) << 10) | (second_code & 0x3FF));
+    }
+    else
+    {
+        sequence_length = 6; /* \uXXXX */
+        codepoint = first_code;
+    }
+
+    /* encode as UTF-8
+     * takes at maximum 4 bytes to encode:
+     * 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
+    if (codepoint < 0x80)
+    {
+        /* normal ascii, encoding 0xxxxxxx */
+        utf8_length = 1;
+    }
+    else if (codepoint < 0x800)
+    {
+        /* two bytes, encoding 110xxxxx 10xxxxxx */
+        utf8_length = 2;
+        first_byte_mark = 0xC0; /* 11000000 */
+    }
+    else if (codepoint < 0x10000)
+    {
+        /* three bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx */
+        utf8_length = 3;
+        first_byte_mark = 0xE0; /* 11100000 */
+    }
+    else if (codepoint <= 0x10FFFF)
+    {
+        /* four bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx 10xxxxxx */
+        utf8_length = 4;
+        first_byte_mark = 0xF0; /* 11110000 */
+    }
+    else
+    {
+        /* invalid unicode codepoint */
+        goto fail;
+    }
+
+    /* encode as utf8 */
+    for (utf8_position = (unsigned char)(utf8_length - 1); utf8_position > 0; utf8_position--)
+    {
+        /* 10xxxxxx */
+        (*output_pointer)[utf8_position] = (unsigned char)((codepoint | 0x80) & 0xBF);
+        codepoint >>= 6;
+    }
+    /* encode first byte */
+    if (utf8_length > 1)
+    {
+        (*output_pointer)[0] = (unsigned char)((codepoint | first_byte_mark) & 0xFF);
+    }
+    else
+    {
+        (*output_pointer)[0] = (unsigned char)(codepoint & 0x7F);
+    }
+
+    *output_pointer += utf8_length;
+
+    return sequence_length;
+
+fail:
+    return 0;
+}
+
+/* Scanning the input several bytes at a time: the SIMD functions stop at the
+ * first interesting byte or when fewer than a vector's worth of bytes are
+ * left, the callers finish the rest byte by byte. */
+#if defined(CJSON_SIMD_SSE2)
+static const unsigned char *find_quote_or_backslash_sse2(const unsigned char *input, const unsigned char * const end)
+{
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+
+    while ((end - input) >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)input);
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+        if (mask != 0)
+        {
+            return input + __builtin_ctz((unsigned int)mask);
+        }
+        input += 16;
+    }
+
+    return input;
+}
+
+static const unsigned char *skip_plain_string_sse2(const unsigned char *input, const unsigned char * const end)
+{
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(' ');
+
+    while ((end - input) >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)input);
+        /* as signed bytes, control characters and everything >= 0x80 are less than ' ' */
+        __m128i special = _mm_or_si128(_mm_cmplt_epi8(chunk, space), _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+        int mask = _mm_movemask_epi8(special);
+        if (mask != 0)
+        {
+            return input + __builtin_ctz((unsigned int)mask);
+        }
+        input += 16;
+    }
+
+    return input;
+}
+
+static const unsigned char *find_newline_sse2(const unsigned char *input, const unsigned char * const end)
+{
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    while ((end - input) >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)input);
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+        if (mask != 0)
+        {
+            return input + __builtin_ctz((unsigned int)mask);
+        }
+        input += 16;
+    }
+
+    return input;
+}
+
+static const unsigned char *skip_whitespace_sse2(const unsigned char *input, const unsigned char * const end)
+{
+    const __m128i space = _mm_set1_epi8(' ');
+
+    while ((end - input) >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)input);
+        /* every byte up to and including ' ' counts as whitespace */
+        int mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(chunk, space), space)) & 0xFFFF;
+        if (mask != 0)
+        {
+            return input + __builtin_ctz((unsigned int)mask);
+        }
+        input += 16;
+    }
+
+    return input;
+}
+#endif
+
+#if defined(CJSON_SIMD_AVX2)
+__attribute__((target("avx2")))
+static const unsigned char *find_quote_or_backslash_avx2(const unsigned char *input, const unsigned char * const end)
+{
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+
+    while ((end - input) >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(const void*)input);
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)));
+        if (mask != 0)
+        {
+            return input + __builtin_ctz(mask);
+        }
+        input += 32;
+    }
+
+    return find_quote_or_backslash_sse2(input, end);
+}
+
+__attribute__((target("avx2")))
+static const unsigned char *skip_plain_string_avx2(const unsigned char *input, const unsigned char * const end)
+{
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i space = _mm256_set1_epi8(' ');
+
+    while ((end - input) >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(const void*)input);
+        __m256i special = _mm256_or_si256(_mm256_cmpgt_epi8(space, chunk), _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(special);
+        if (mask != 0)
+        {
+            return input + __builtin_ctz(mask);
+        }
+        input += 32;
+    }
+
+    return skip_plain_string_sse2(input, end);
+}
+
+__attribute__((target("avx2")))
+static const unsigned char *find_newline_avx2(const unsigned char *input, const unsigned char * const end)
+{
+    const __m256i newline = _mm256_set1_epi8('\n');
+
+    while ((end - input) >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(const void*)input);
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline));
+        if (mask != 0)
+        {
+            return input + __builtin_ctz(mask);
+        }
+        input += 32;
+    }
+
+    return find_newline_sse2(input, end);
+}
+
+__attribute__((target("avx2")))
+static const unsigned char *skip_whitespace_avx2(const unsigned char *input, const unsigned char * const end)
+{
+    const __m256i space = _mm256_set1_epi8(' ');
+
+    while ((end - input) >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(const void*)input);
+        unsigned int mask = ~(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(chunk, space), space));
+        if (mask != 0)
+        {
+            return input + __builtin_ctz(mask);
+        }
+        input += 32;
+    }
+
+    return skip_whitespace_sse2(input, end);
+}
+#endif
+
+/* Find the first '\"' or '\\' in [input, end), returns end if there is none. */
+static const unsigned char *find_quote_or_backslash(const unsigned char *input, const unsigned char * const end)
+{
+#if defined(CJSON_SIMD_AVX2)
+    if (__builtin_cpu_supports("avx2"))
+    {
+        input = find_quote_or_backslash_avx2(input, end);
+    }
+    else
+#endif
+#if defined(CJSON_SIMD_SSE2)
+    {
+        input = find_quote_or_backslash_sse2(input, end);
+    }
+#endif
+
+    while ((input < end) && (*input != '\"') && (*input != '\\'))
+    {
+        input++;
+    }
+
+    return input;
+}
+
+/* Find the first byte in [input, end) that is '\"', '\\', a control character or not ASCII, returns end if there is none. */
+static const unsigned char *skip_plain_string(const unsigned char *input, const unsigned char * const end)
+{
+#if defined(CJSON_SIMD_AVX2)
+    if (__builtin_cpu_supports("avx2"))
+    {
+        input = skip_plain_string_avx2(input, end);
+    }
+    else
+#endif
+#if defined(CJSON_SIMD_SSE2)
+    {
+        input = skip_plain_string_sse2(input, end);
+    }
+#endif
+
+    while ((input < end) && (*input >= ' ') && (*input < 0x80) && (*input != '\"') && (*input != '\\'))
+    {
+        input++;
+    }
+
+    return input;
+}
+
+/* Find the first '\n' in [input, end), returns end if there is none. */
+static const unsigned char *find_newline(const unsigned char *input, const unsigned char * const end)
+{
+#if defined(CJSON_SIMD_AVX2)
+    if (__builtin_cpu_supports("avx2"))
+    {
+        input = find_newline_avx2(input, end);
+    }
+    else
+#endif
+#if defined(CJSON_SIMD_SSE2)
+    {
+        input = find_newline_sse2(input, end);
+    }
+#endif
+
+    while ((input < end) && (*input != '\n'))
+    {
+        input++;
+    }
+
+    return input;
+}
+
+/* Find the first byte in [input, end) that isn't whitespace (> ' '), returns end if there is none. */
+static const unsigned char *skip_whitespace(const unsigned char *input, const unsigned char * const end)
+{
+#if defined(CJSON_SIMD_AVX2)
+    if (__builtin_cpu_supports("avx2"))
+    {
+        input = skip_whitespace_avx2(input, end);
+    }
+    else
+#endif
+#if defined(CJSON_SIMD_SSE2)
+    {
+        input = skip_whitespace_sse2(input, end);
+    }
+#endif
+
+    while ((input < end) && (*input <= 32))
+    {
+        input++;
+    }
+
+    return input;
+}
+
+/* Parse the input text into an unescaped cinput, and populate item. */
+static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_buffer)
+{
+    const unsigned char *input_pointer = buffer_at_offset(input_buffer) + 1;
+    const unsigned char *input_end = buffer_at_offset(input_buffer) + 1;
+    const unsigned char * const buffer_end = input_buffer->content + input_buffer->length;
+    unsigned char *output_pointer = NULL;
+    unsigned char *output = NULL;
+    cJSON_bool has_escapes = false;
+
+    /* not a string */
+    if (buffer_at_offset(input_buffer)[0] != '\"')
+    {
+        goto fail;
+    }
+
+    /* find the end of the string literal */
+    for (;;)
+    {
+        input_end = find_quote_or_backslash(input_end, buffer_end);
+        if (input_end == buffer_end)
+        {
+            goto fail; /* string ended unexpectedly */
+        }
+        if (*input_end == '\"')
+        {
+            break;
+        }
+
+        /* escape sequence, skip the escaped character because it might be a quote */
+        if ((input_end + 1) >= buffer_end)
+        {
+            /* prevent buffer overflow when last input character is a backslash */
+            goto fail;
+        }
+        has_escapes = true;
+        input_end += 2;
+    }
+
+    if (input_buffer->in_situ != NULL)
+    {
+        /* unescape in place, the output never gets ahead of the input */
+        output = input_buffer->in_situ + (input_pointer - input_buffer->content);
+    }
+    else
+    {
+        /* escape sequences never get longer, so this is at most how much we need for the output */
+        output = (unsigned char*)internal_allocate(&input_buffer->hooks, (size_t)(input_end - input_pointer) + sizeof(""));
+        if (output == NULL)
+        {
+            goto fail; /* allocation failure */
+        }
+    }
+
+    output_pointer = output;
+    if (!has_escapes)
+    {
+        if (output_pointer != input_pointer)
+        {
+            memcpy(output_pointer, input_pointer, (size_t)(input_end - input_pointer));
+        }
+        output_pointer += input_end - input_pointer;
+        input_pointer = input_end;
+    }
+    /* loop through the string literal */
+    while (input_pointer < input_end)
+    {
         if (*input_pointer != '\\')
         {
-            *output_pointer++ = *input_pointer++;
+            /* copy everything up to the next escape sequence at once */
+            const unsigned char *run_end = (const unsigned char*)memchr(input_pointer, '\\', (size_t)(input_end - input_pointer));
+            if (run_end == NULL)
+            {
+                run_end = input_end;
+            }
+            memmove(output_pointer, input_pointer, (size_t)(run_end - input_pointer));
+            output_pointer += run_end - input_pointer;
+            input_pointer = run_end;
+        }
+        /* escape sequence */
+        else
+        {
+            unsigned char sequence_length = 2;
+            if ((input_end - input_pointer) < 1)
+            {
+                goto fail;
+            }
+
+            switch (input_pointer[1])
+            {
+                case 'b':
+                    *output_pointer++ = '\b';
+                    break;
+                case 'f':
+                    *output_pointer++ = '\f';
+                    break;
+                case 'n':
+                    *output_pointer++ = '\n';
+                    break;
+                case 'r':
+                    *output_pointer++ = '\r';
+                    break;
+                case 't':
+                    *output_pointer++ = '\t';
+                    break;
+                case '\"':
+                case '\\':
+                case '/':
+                    *output_pointer++ = input_pointer[1];
+                    break;
+
+                /* UTF-16 literal */
+                case 'u':
+                    sequence_length = utf16_literal_to_utf8(input_pointer, input_end, &output_pointer);
+                    if (sequence_length == 0)
+                    {
+                        /* failed to convert UTF16-literal to UTF-8 */
+                        goto fail;
+                    }
+                    break;
+
+                default:
+                    goto fail;
+            }
+            input_pointer += sequence_length;
+        }
+    }
+
+    /* zero terminate the output, in place this overwrites at most the closing quote */
+    *output_pointer = '\0';
+
+    set_item_type(item, cJSON_String);
+    if (input_buffer->in_situ != NULL)
+    {
+        item->type |= cJSON_InSitu;
+    }
+    item->valuestring = (char*)output;
+
+    input_buffer->offset = (size_t) (input_end - input_buffer->content);
+    input_buffer->offset++;
+
+    return true;
+
+fail:
+    if ((output != NULL) && (input_buffer->in_situ == NULL))
+    {
+        internal_deallocate(&input_buffer->hooks, output);
+    }
+
+    if (input_pointer != NULL)
+    {
+        input_buffer->offset = (size_t)(input_pointer - input_buffer->content);
+    }
+
+    return false;
+}
+
+/* Count the additional characters needed to escape input, and its length. */
+static size_t count_escape_characters(const unsigned char * const input, size_t * const input_length)
+{
+    const unsigned char *input_pointer = NULL;
+    size_t escape_characters = 0;
+
+    for (input_pointer = input; *input_pointer; input_pointer++)
+    {
+        switch (*input_pointer)
+        {
+            case '\"':
+            case '\\':
+            case '\b':
+            case '\f':
+            case '\n':
+            case '\r':
+            case '\t':
+                /* one character escape sequence */
+                escape_characters++;
+                break;
+            default:
+                if (*input_pointer < 32)
+                {
+                    /* UTF-16 escape sequence uXXXX */
+                    escape_characters += 5;
+                }
+                break;
+        }
+    }
+    *input_length = (size_t)(input_pointer - input);
+
+    return escape_characters;
+}
+
+/* Render the cstring provided to an escaped version that can be printed. */
+static cJSON_bool print_string_ptr(const unsigned char * const input, printbuffer * const output_buffer)
+{
+    const unsigned char *input_pointer = NULL;
+    unsigned char *output = NULL;
+    unsigned char *output_pointer = NULL;
+    size_t output_length = 0;
+    size_t input_length = 0;
+    /* numbers of additional characters needed for escaping */
+    size_t escape_characters = 0;
+
+    if (output_buffer == NULL)
+    {
+        return false;
+    }
+
+    /* empty string */
+    if (input == NULL)
+    {
+        output = ensure(output_buffer, sizeof("\"\"") - 1);
+        if (output == NULL)
+        {
+            return false;
+        }
+        strcpy((char*)output, "\"\"");
+        output_buffer->offset += sizeof("\"\"") - 1;
+
+        return true;
+    }
+
+    escape_characters = count_escape_characters(input, &input_length);
+    output_length = input_length + escape_characters;
+
+    output = ensure(output_buffer, output_length + sizeof("\"\"") - 1);
+    if (output == NULL)
+    {
+        return false;
+    }
+
+    /* no characters have to be escaped */
+    if (escape_characters == 0)
+    {
+        output[0] = '\"';
+        memcpy(output + 1, input, output_length);
+        output[output_length + 1] = '\"';
+        output[output_length + 2] = '\0';
+        output_buffer->offset += output_length + sizeof("\"\"") - 1;
+
+        return true;
+    }
+
+    output[0] = '\"';
+    output_pointer = output + 1;
+    /* copy the string */
+    for (input_pointer = input; *input_pointer != '\0'; (void)input_pointer++, output_pointer++)
+    {
+        if ((*input_pointer > 31) && (*input_pointer != '\"') && (*input_pointer != '\\'))
+        {
+            /* normal character, copy */
+            *output_pointer = *input_pointer;
+        }
+        else
+        {
+            /* character needs to be escaped */
+            *output_pointer++ = '\\';
+            switch (*input_pointer)
+            {
+                case '\\':
+                    *output_pointer = '\\';
+                    break;
+                case '\"':
+                    *output_pointer = '\"';
+                    break;
+                case '\b':
+                    *output_pointer = 'b';
+                    break;
+                case '\f':
+                    *output_pointer = 'f';
+                    break;
+                case '\n':
+                    *output_pointer = 'n';
+                    break;
+                case '\r':
+                    *output_pointer = 'r';
+                    break;
+                case '\t':
+                    *output_pointer = 't';
+                    break;
+                default:
+                    /* escape and print as unicode codepoint */
+                    sprintf((char*)output_pointer, "u%04x", *input_pointer);
+                    output_pointer += 4;
+                    break;
+            }
+        }
+    }
+    output[output_length + 1] = '\"';
+    output[output_length + 2] = '\0';
+    output_buffer->offset += output_length + sizeof("\"\"") - 1;
+
+    return true;
+}
+
+/* Invoke print_string_ptr (which is useful) on an item. */
+static cJSON_bool print_string(const cJSON * const item, printbuffer * const p)
+{
+    return print_string_ptr((unsigned char*)item->valuestring, p);
+}
+
+/* The keys of a document that is parsed with cJSON_ParseInternKeys, so every key is only stored once.
+ * Open addressing with linear probing, the pool holds a reference to each key. */
+typedef struct key_pool
+{
+    char **slots; /* NULL if the slot is free */
+    size_t mask; /* number of slots - 1, the number of slots is a power of two */
+    size_t count;
+    cJSON_bool shared; /* false in arenas, where keys are released with the arena and not counted */
+} key_pool;
+
+static void key_pool_free(key_pool * const pool, const internal_hooks * const hooks)
+{
+    size_t i = 0;
+
+    if (pool->slots == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; pool->shared && (i <= pool->mask); i++)
+    {
+        if (pool->slots[i] != NULL)
+        {
+            shared_key_release(pool->slots[i], hooks);
+        }
+    }
+    hooks->deallocate(pool->slots);
+    pool->slots = NULL;
+}
+
+/* Find the key with the given characters. */
+static char *key_pool_find(const key_pool * const pool, const unsigned char * const string, const size_t length, const size_t hash)
+{
+    size_t position = 0;
+
+    if (pool->slots == NULL)
+    {
+        return NULL;
+    }
+
+    for (position = hash & pool->mask; pool->slots[position] != NULL; position = (position + 1) & pool->mask)
+    {
+        char *key = pool->slots[position];
+        if ((shared_key_header(key)->hash == hash) && (shared_key_header(key)->length == length) && (memcmp(key, string, length) == 0))
+        {
+            return key;
+        }
+    }
+
+    return NULL;
+}
+
+static cJSON_bool key_pool_insert(key_pool * const pool, char * const key, const internal_hooks * const hooks)
+{
+    size_t position = 0;
+
+    /* keep the load factor at 1/2 or less */
+    if ((pool->slots == NULL) || ((pool->count + 1) * 2 > (pool->mask + 1)))
+    {
+        size_t slots = (pool->slots == NULL) ? 64 : ((pool->mask + 1) * 2);
+        char **old_slots = pool->slots;
+        size_t old_mask = pool->mask;
+        size_t i = 0;
+
+        pool->slots = (char**)hooks->allocate(slots * sizeof(char*));
+        if (pool->slots == NULL)
+        {
+            if (hooks->arena != NULL)
+            {
+                /* the keys come from the arena, the pool doesn't */
+                hooks->arena->out_of_memory = true;
+            }
+            pool->slots = old_slots;
+            return false;
+        }
+        memset(pool->slots, '\0', slots * sizeof(char*));
+        pool->mask = slots - 1;
+
+        for (i = 0; (old_slots != NULL) && (i <= old_mask); i++)
+        {
+            if (old_slots[i] != NULL)
+            {
+                for (position = shared_key_header(old_slots[i])->hash & pool->mask; pool->slots[position] != NULL; position = (position + 1) & pool->mask)
+                {
+                }
+                pool->slots[position] = old_slots[i];
+            }
+        }
+        if (old_slots != NULL)
+        {
+            hooks->deallocate(old_slots);
+        }
+    }
+
+    for (position = shared_key_header(key)->hash & pool->mask; pool->slots[position] != NULL; position = (position + 1) & pool->mask)
+    {
+    }
+    pool->slots[position] = key;
+    pool->count++;
+
+    return true;
+}
+
+/* Parse the key of an object member. Keys that were seen before are shared instead of copied. */
+static cJSON_bool parse_shared_key(cJSON * const item, parse_buffer * const input_buffer)
+{
+    key_pool * const pool = input_buffer->keys;
+    const unsigned char * const buffer_end = input_buffer->content + input_buffer->length;
+    char *key = NULL;
+    size_t length = 0;
+    size_t hash = 0;
+
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '\"'))
+    {
+        const unsigned char *start = buffer_at_offset(input_buffer) + 1;
+        const unsigned char *end = find_quote_or_backslash(start, buffer_end);
+
+        if ((end < buffer_end) && (*end == '\"'))
+        {
+            /* no escape sequences, look the key up as it is */
+            key = key_pool_find(pool, start, (size_t)(end - start), hash_key_length(start, (size_t)(end - start)));
+            if (key != NULL)
+            {
+                input_buffer->offset = (size_t)(end - input_buffer->content) + 1;
+                goto found;
+            }
+        }
+    }
+
+    /* a new key, or one with escape sequences */
+    if (!parse_string(item, input_buffer))
+    {
+        return false;
+    }
+    length = strlen(item->valuestring);
+    hash = hash_key_length((const unsigned char*)item->valuestring, length);
+    key = key_pool_find(pool, (const unsigned char*)item->valuestring, length, hash);
+    if (key == NULL)
+    {
+        key = shared_key_create((const unsigned char*)item->valuestring, length, hash, &input_buffer->hooks);
+        if ((key != NULL) && !key_pool_insert(pool, key, &input_buffer->hooks))
+        {
+            if (pool->shared)
+            {
+                shared_key_release(key, &input_buffer->hooks);
+            }
+            key = NULL;
+        }
+    }
+    internal_deallocate(&input_buffer->hooks, item->valuestring);
+    item->valuestring = NULL;
+    if (key == NULL)
+    {
+        return false;
+    }
+
+found:
+    item->string = key;
+    if (pool->shared)
+    {
+        shared_key_retain(key);
+        item->type |= cJSON_KeyIsShared;
+    }
+
+    return true;
+}
+
+/* Predeclare these prototypes. */
+static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer);
+static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON_bool print_array(const cJSON * const item, printbuffer * const output_buffer);
+static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON_bool print_object(const cJSON * const item, printbuffer * const output_buffer);
+
+/* Utility to jump whitespace and cr/lf */
+static parse_buffer *buffer_skip_whitespace(parse_buffer * const buffer)
+{
+    if ((buffer == NULL) || (buffer->content == NULL))
+    {
+        return NULL;
+    }
+
+    if (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] <= 32))
+    {
+        buffer->offset = (size_t)(skip_whitespace(buffer_at_offset(buffer), buffer->content + buffer->length) - buffer->content);
+    }
+
+    if (buffer->offset == buffer->length)
+    {
+        buffer->offset--;
+    }
+
+    return buffer;
+}
+
+/* Parse an object - create a new root, and populate. */
+static cJSON *parse(cJSON_Context * const context, const char *value, const char **return_parse_end, cJSON_bool require_null_terminated, int flags, const internal_hooks * const hooks, char *in_situ)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0 }, 0, 0, 0, 0 };
+    key_pool keys = { 0, 0, 0, 0 };
+    cJSON *item = NULL;
+
+    /* reset error position */
+    context->error.json = NULL;
+    context->error.position = 0;
+
+    if (value == NULL)
+    {
+        goto fail;
+    }
+
+    buffer.content = (const unsigned char*)value;
+    buffer.length = strlen((const char*)value) + sizeof("");
+    buffer.offset = 0;
+    buffer.hooks = *hooks;
+    buffer.flags = flags;
+    buffer.in_situ = (unsigned char*)in_situ;
+    buffer.nesting_limit = context->nesting_limit;
+    if ((flags & cJSON_ParseInternKeys) && (in_situ == NULL))
+    {
+        /* keys parsed in place are not copied anyway */
+        keys.shared = (hooks->arena == NULL);
+        buffer.keys = &keys;
+    }
+
+    item = cJSON_New_Item(hooks);
+    if (item == NULL) /* memory fail */
+    {
+        goto fail;
+    }
+
+    if (!parse_value(item, buffer_skip_whitespace(&buffer)))
+    {
+        /* parse failure. ep is set. */
+        goto fail;
+    }
+
+    /* if we require null-terminated JSON without appended garbage, skip and then check for a null terminator */
+    if (require_null_terminated)
+    {
+        buffer_skip_whitespace(&buffer);
+        if ((buffer.offset >= buffer.length) || buffer_at_offset(&buffer)[0] != '\0')
+        {
+            goto fail;
+        }
+    }
+    if (return_parse_end)
+    {
+        *return_parse_end = (const char*)buffer_at_offset(&buffer);
+    }
+
+    key_pool_free(&keys, hooks);
+    return item;
+
+fail:
+    if (item != NULL)
+    {
+        delete_item(item, hooks);
+    }
+    key_pool_free(&keys, hooks);
+
+    if (value != NULL)
+    {
+        context->error.json = (const unsigned char*)value;
+        context->error.position = 0;
+
+        if (buffer.offset < buffer.length)
+        {
+            context->error.position = buffer.offset;
+        }
+        else if (buffer.length > 0)
+        {
+            context->error.position = buffer.length - 1;
+        }
+
+        if (return_parse_end != NULL)
+        {
+            *return_parse_end = (const char*)context->error.json + context->error.position;
+        }
+    }
+
+    return NULL;
+}
+
+/* parse for the functions without a context, errors go to cJSON_GetErrorPtr unless return_parse_end gets them */
+static cJSON *parse_global(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated, int flags, const internal_hooks * const hooks, char *in_situ)
+{
+    cJSON_Context context;
+    cJSON *item = NULL;
+
+    memset(&context, '\0', sizeof(context));
+    context.nesting_limit = CJSON_NESTING_LIMIT;
+
+    item = parse(&context, value, return_parse_end, require_null_terminated, flags, hooks, in_situ);
+    if (return_parse_end == NULL)
+    {
+        global_error = context.error;
+    }
+    else
+    {
+        global_error.json = NULL;
+        global_error.position = 0;
+    }
+
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    return parse_global(value, return_parse_end, require_null_terminated, 0, &global_hooks, NULL);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithFlags(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated, int flags)
+{
+    return parse_global(value, return_parse_end, require_null_terminated, flags, &global_hooks, NULL);
+}
+
+/* Default options for cJSON_Parse */
+CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value)
+{
+    return cJSON_ParseWithOpts(value, 0, 0);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInArenaWithOpts(cJSON_Arena *arena, const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    internal_hooks hooks;
+
+    if (arena == NULL)
+    {
+        return NULL;
+    }
+
+    hooks = arena_hooks(arena);
+    return parse_global(value, return_parse_end, require_null_terminated, 0, &hooks, NULL);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInArena(cJSON_Arena *arena, const char *value)
+{
+    return cJSON_ParseInArenaWithOpts(arena, value, 0, 0);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSituWithOpts(char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    return parse_global(value, return_parse_end, require_null_terminated, 0, &global_hooks, value);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSitu(char *value)
+{
+    return cJSON_ParseInSituWithOpts(value, 0, 0);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithContext(cJSON_Context *context, const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    if (context == NULL)
+    {
+        return NULL;
+    }
+
+    return parse(context, value, return_parse_end, require_null_terminated, context->flags, &context->hooks, NULL);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSituWithContext(cJSON_Context *context, char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    if (context == NULL)
+    {
+        return NULL;
+    }
+
+    return parse(context, value, return_parse_end, require_null_terminated, context->flags, &context->hooks, value);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInArenaWithContext(cJSON_Context *context, cJSON_Arena *arena, const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    internal_hooks hooks;
+
+    if ((context == NULL) || (arena == NULL))
+    {
+        return NULL;
+    }
+
+    hooks = arena_hooks(arena);
+    return parse(context, value, return_parse_end, require_null_terminated, context->flags, &hooks, NULL);
+}
+
+CJSON_PUBLIC(void) cJSON_DeleteWithContext(cJSON_Context *context, cJSON *item)
+{
+    if (context != NULL)
+    {
+        delete_item(item, &context->hooks);
+    }
+}
+
+/* Batches of newline delimited documents. The input is copied once and split into one
+ * range of whole lines per worker. Every worker finds the records in its range, parses
+ * them in place into an arena of its own and collects their roots, which are put
+ * together in order at the end. */
+#define CJSON_BATCH_BLOCK_SIZE (64 * 1024)
+/* smaller inputs don't get more workers, starting a thread costs more than parsing that */
+#define CJSON_BATCH_MIN_RANGE (64 * 1024)
+
+struct cJSON_Batch
+{
+    char *text; /* the copy of the input the records were parsed in */
+    cJSON **items; /* roots in input order, NULL where parsing failed */
+    size_t count;
+    cJSON_Arena **arenas; /* one per worker */
+    size_t arena_count;
+};
+
+typedef struct
+{
+    unsigned char *start;
+    unsigned char *end; /* start of the next range, or the end of the input */
+    int flags;
+    cJSON_Arena *arena;
+    cJSON **items;
+    size_t count;
+    size_t capacity;
+    cJSON_bool failed; /* out of memory */
+} batch_worker;
+
+static cJSON_bool batch_worker_append(batch_worker * const worker, cJSON * const item)
+{
+    if (worker->count == worker->capacity)
+    {
+        size_t capacity = (worker->capacity < 64) ? 64 : (worker->capacity * 2);
+        cJSON **grown = NULL;
+
+        if (capacity > ((size_t)-1 / sizeof(cJSON*)))
+        {
+            return false;
+        }
+        grown = (cJSON**)global_hooks.allocate(capacity * sizeof(cJSON*));
+        if (grown == NULL)
+        {
+            return false;
+        }
+        if (worker->items != NULL)
+        {
+            memcpy(grown, worker->items, worker->count * sizeof(cJSON*));
+            global_hooks.deallocate(worker->items);
+        }
+        worker->items = grown;
+        worker->capacity = capacity;
+    }
+
+    worker->items[worker->count++] = item;
+
+    return true;
+}
+
+static void *batch_worker_run(void *argument)
+{
+    batch_worker * const worker = (batch_worker*)argument;
+    internal_hooks hooks = arena_hooks(worker->arena);
+    cJSON_Context context;
+    unsigned char *line = worker->start;
+
+    memset(&context, '\0', sizeof(context));
+    context.nesting_limit = CJSON_NESTING_LIMIT;
+
+    while (line < worker->end)
+    {
+        unsigned char *newline = line + (find_newline(line, worker->end) - line);
+
+        /* the last line ends at the '\0' after the copy of the input */
+        *newline = '\0';
+        /* blank lines aren't records */
+        if (skip_whitespace(line, newline) != newline)
+        {
+            cJSON *item = NULL;
+
+            worker->arena->out_of_memory = false;
+            item = parse(&context, (const char*)line, NULL, true, worker->flags, &hooks, (char*)line);
+            /* a line that only failed for lack of memory fails the whole batch */
+            if (worker->arena->out_of_memory || !batch_worker_append(worker, item))
+            {
+                worker->failed = true;
+                break;
+            }
+        }
+        line = newline + 1;
+    }
+
+    return NULL;
+}
+
+static int batch_default_threads(void)
+{
+#if defined(CJSON_THREADS) && defined(_SC_NPROCESSORS_ONLN)
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > 0)
+    {
+        return (cpus > INT_MAX) ? INT_MAX : (int)cpus;
+    }
+#endif
+    return 1;
+}
+
+CJSON_PUBLIC(cJSON_Batch *) cJSON_ParseBatch(const char *json, size_t length, int flags, int threads)
+{
+    cJSON_Batch *batch = NULL;
+    batch_worker *workers = NULL;
+    unsigned char *text = NULL;
+    unsigned char *range_start = NULL;
+    size_t worker_count = 0;
+    size_t total = 0;
+    size_t i = 0;
+#if defined(CJSON_THREADS)
+    pthread_t *thread_ids = NULL;
+    cJSON_bool *started = NULL;
+#endif
+
+    if ((json == NULL) || (length == (size_t)-1))
+    {
+        return NULL;
+    }
+
+    if (threads <= 0)
+    {
+        threads = batch_default_threads();
+    }
+#if !defined(CJSON_THREADS)
+    threads = 1;
+#endif
+    worker_count = (length / CJSON_BATCH_MIN_RANGE) + 1;
+    if (worker_count > (size_t)threads)
+    {
+        worker_count = (size_t)threads;
+    }
+
+    batch = (cJSON_Batch*)global_hooks.allocate(sizeof(cJSON_Batch));
+    if (batch == NULL)
+    {
+        return NULL;
+    }
+    memset(batch, '\0', sizeof(cJSON_Batch));
+
+    text = (unsigned char*)global_hooks.allocate(length + 1);
+    batch->text = (char*)text;
+    batch->arenas = (cJSON_Arena**)global_hooks.allocate(worker_count * sizeof(cJSON_Arena*));
+    workers = (batch_worker*)global_hooks.allocate(worker_count * sizeof(batch_worker));
+    if (workers != NULL)
+    {
+        /* the fail path frees what the workers collected */
+        memset(workers, '\0', worker_count * sizeof(batch_worker));
+    }
+#if defined(CJSON_THREADS)
+    thread_ids = (pthread_t*)global_hooks.allocate(worker_count * sizeof(pthread_t));
+    started = (cJSON_bool*)global_hooks.allocate(worker_count * sizeof(cJSON_bool));
+    if ((thread_ids == NULL) || (started == NULL))
+    {
+        goto fail;
+    }
+#endif
+    if ((text == NULL) || (batch->arenas == NULL) || (workers == NULL))
+    {
+        goto fail;
+    }
+    memcpy(text, json, length);
+    text[length] = '\0';
+
+    /* equal shares of the input, each moved forward to the start of a line */
+    range_start = text;
+    for (i = 0; i < worker_count; i++)
+    {
+        unsigned char *range_end = text + length;
+        if (i + 1 < worker_count)
+        {
+            unsigned char *split = text + ((length / worker_count) * (i + 1));
+            if (split < range_start)
+            {
+                split = range_start;
+            }
+            range_end = split + (find_newline(split, text + length) - split);
+            if (range_end < text + length)
+            {
+                range_end++;
+            }
+        }
+
+        workers[i].start = range_start;
+        workers[i].end = range_end;
+        workers[i].flags = flags;
+        workers[i].arena = cJSON_CreateArena(CJSON_BATCH_BLOCK_SIZE);
+        batch->arenas[i] = workers[i].arena;
+        batch->arena_count++;
+        if (workers[i].arena == NULL)
+        {
+            goto fail;
+        }
+        range_start = range_end;
+    }
+
+#if defined(CJSON_THREADS)
+    /* the calling thread takes the first range itself, and any range whose thread didn't start */
+    for (i = 1; i < worker_count; i++)
+    {
+        started[i] = (pthread_create(&thread_ids[i], NULL, batch_worker_run, &workers[i]) == 0);
+    }
+    batch_worker_run(&workers[0]);
+    for (i = 1; i < worker_count; i++)
+    {
+        if (started[i])
+        {
+            pthread_join(thread_ids[i], NULL);
+        }
+        else
+        {
+            batch_worker_run(&workers[i]);
+        }
+    }
+#else
+    for (i = 0; i < worker_count; i++)
+    {
+        batch_worker_run(&workers[i]);
+    }
+#endif
+
+    for (i = 0; i < worker_count; i++)
+    {
+        if (workers[i].failed)
+        {
+            goto fail;
+        }
+        total += workers[i].count;
+    }
+
+    batch->items = (cJSON**)global_hooks.allocate((total > 0) ? (total * sizeof(cJSON*)) : 1);
+    if (batch->items == NULL)
+    {
+        goto fail;
+    }
+    for (i = 0; i < worker_count; i++)
+    {
+        if (workers[i].count > 0)
+        {
+            memcpy(batch->items + batch->count, workers[i].items, workers[i].count * sizeof(cJSON*));
+            batch->count += workers[i].count;
+        }
+        if (workers[i].items != NULL)
+        {
+            global_hooks.deallocate(workers[i].items);
+        }
+    }
+
+    global_hooks.deallocate(workers);
+#if defined(CJSON_THREADS)
+    global_hooks.deallocate(thread_ids);
+    global_hooks.deallocate(started);
+#endif
+
+    return batch;
+
+fail:
+    if (workers != NULL)
+    {
+        for (i = 0; i < worker_count; i++)
+        {
+            if (workers[i].items != NULL)
+            {
+                global_hooks.deallocate(workers[i].items);
+            }
+        }
+        global_hooks.deallocate(workers);
+    }
+#if defined(CJSON_THREADS)
+    if (thread_ids != NULL)
+    {
+        global_hooks.deallocate(thread_ids);
+    }
+    if (started != NULL)
+    {
+        global_hooks.deallocate(started);
+    }
+#endif
+    cJSON_DeleteBatch(batch);
+
+    return NULL;
+}
+
+CJSON_PUBLIC(size_t) cJSON_GetBatchSize(const cJSON_Batch *batch)
+{
+    return (batch != NULL) ? batch->count : 0;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_GetBatchItem(const cJSON_Batch *batch, size_t index)
+{
+    if ((batch == NULL) || (index >= batch->count))
+    {
+        return NULL;
+    }
+
+    return batch->items[index];
+}
+
+CJSON_PUBLIC(void) cJSON_DeleteBatch(cJSON_Batch *batch)
+{
+    size_t i = 0;
+
+    if (batch == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < batch->arena_count; i++)
+    {
+        cJSON_DeleteArena(batch->arenas[i]);
+    }
+    if (batch->arenas != NULL)
+    {
+        global_hooks.deallocate(batch->arenas);
+    }
+    if (batch->items != NULL)
+    {
+        global_hooks.deallocate(batch->items);
+    }
+    if (batch->text != NULL)
+    {
+        global_hooks.deallocate(batch->text);
+    }
+    global_hooks.deallocate(batch);
+}
+
+/* Validation checks the text against the JSON grammar in one pass, without building
+ * anything. Every helper gets the position of a token, returns false if the token is
+ * invalid, and otherwise moves the position behind it. On failure the position is the
+ * offending byte. */
+#define is_json_whitespace(c) (((c) == ' ') || ((c) == '\t') || ((c) == '\n') || ((c) == '\r'))
+#define is_digit(c) (((c) >= '0') && ((c) <= '9'))
+#define is_object_at(objects, level) ((((objects)[(level) / 8] >> ((level) % 8)) & 1) != 0)
+
+static const unsigned char *validate_skip_whitespace(const unsigned char *input, const unsigned char * const end)
+{
+    while ((input < end) && is_json_whitespace(*input))
+    {
+        input++;
+    }
+
+    return input;
+}
+
+static cJSON_bool validate_hex4(const unsigned char * const input, const unsigned char * const end, unsigned int * const code)
+{
+    size_t i = 0;
+
+    if ((end - input) < 4)
+    {
+        return false;
+    }
+    for (i = 0; i < 4; i++)
+    {
+        if (!is_digit(input[i]) && !(((input[i] | 0x20) >= 'a') && ((input[i] | 0x20) <= 'f')))
+        {
+            return false;
+        }
+    }
+    *code = parse_hex4(input);
+
+    return true;
+}
+
+/* one UTF-8 encoded character starting with a byte >= 0x80, see table 3-7 of the Unicode standard */
+static cJSON_bool validate_utf8(const unsigned char ** const position, const unsigned char * const end)
+{
+    const unsigned char *input = *position;
+    unsigned char lowest = 0x80;
+    unsigned char highest = 0xBF;
+    size_t continuation = 0;
+    size_t i = 0;
+
+    if ((*input >= 0xC2) && (*input <= 0xDF))
+    {
+        continuation = 1;
+    }
+    else if ((*input >= 0xE0) && (*input <= 0xEF))
+    {
+        continuation = 2;
+        /* no overlong encodings and no surrogates */
+        lowest = (*input == 0xE0) ? 0xA0 : 0x80;
+        highest = (*input == 0xED) ? 0x9F : 0xBF;
+    }
+    else if ((*input >= 0xF0) && (*input <= 0xF4))
+    {
+        continuation = 3;
+        /* no overlong encodings and nothing above U+10FFFF */
+        lowest = (*input == 0xF0) ? 0x90 : 0x80;
+        highest = (*input == 0xF4) ? 0x8F : 0xBF;
+    }
+    else
+    {
+        return false;
+    }
+
+    if ((size_t)(end - input) <= continuation)
+    {
+        *position = end;
+        return false;
+    }
+    for (i = 1; i <= continuation; i++)
+    {
+        if ((input[i] < lowest) || (input[i] > highest))
+        {
+            *position = input + i;
+            return false;
+        }
+        lowest = 0x80;
+        highest = 0xBF;
+    }
+
+    *position = input + continuation + 1;
+    return true;
+}
+
+/* position is at the opening quote */
+static cJSON_bool validate_string(const unsigned char ** const position, const unsigned char * const end)
+{
+    const unsigned char *input = *position + 1;
+
+    for (;;)
+    {
+        input = skip_plain_string(input, end);
+        if (input >= end)
+        {
+            break;
+        }
+
+        if (*input == '\"')
+        {
+            *position = input + 1;
+            return true;
+        }
+        else if (*input == '\\')
+        {
+            unsigned int code = 0;
+
+            if ((end - input) < 2)
+            {
+                input = end;
+                break;
+            }
+            switch (input[1])
+            {
+                case '\"':
+                case '\\':
+                case '/':
+                case 'b':
+                case 'f':
+                case 'n':
+                case 'r':
+                case 't':
+                    input += 2;
+                    continue;
+
+                case 'u':
+                    break;
+
+                default:
+                    goto fail;
+            }
+
+            /* a high surrogate has to be followed by an escaped low surrogate, which can't come alone */
+            if (!validate_hex4(input + 2, end, &code) || ((code >= 0xDC00) && (code <= 0xDFFF)))
+            {
+                goto fail;
+            }
+            input += 6;
+            if ((code >= 0xD800) && (code <= 0xDBFF))
+            {
+                if (((end - input) < 2) || (input[0] != '\\') || (input[1] != 'u')
+                        || !validate_hex4(input + 2, end, &code) || (code < 0xDC00) || (code > 0xDFFF))
+                {
+                    goto fail;
+                }
+                input += 6;
+            }
+        }
+        else if (*input >= 0x80)
+        {
+            if (!validate_utf8(&input, end))
+            {
+                goto fail;
+            }
+        }
+        else
+        {
+            /* control characters have to be escaped */
+            goto fail;
+        }
+    }
+
+fail:
+    *position = input;
+    return false;
+}
+
+/* -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)? */
+static cJSON_bool validate_number(const unsigned char ** const position, const unsigned char * const end)
+{
+    const unsigned char *input = *position;
+
+    if ((input < end) && (*input == '-'))
+    {
+        input++;
+    }
+    if ((input < end) && (*input == '0'))
+    {
+        input++;
+    }
+    else if ((input < end) && is_digit(*input))
+    {
+        while ((input < end) && is_digit(*input))
+        {
+            input++;
+        }
+    }
+    else
+    {
+        goto fail;
+    }
+
+    if ((input < end) && (*input == '.'))
+    {
+        input++;
+        if ((input >= end) || !is_digit(*input))
+        {
+            goto fail;
+        }
+        while ((input < end) && is_digit(*input))
+        {
+            input++;
+        }
+    }
+
+    if ((input < end) && ((*input == 'e') || (*input == 'E')))
+    {
+        input++;
+        if ((input < end) && ((*input == '+') || (*input == '-')))
+        {
+            input++;
+        }
+        if ((input >= end) || !is_digit(*input))
+        {
+            goto fail;
+        }
+        while ((input < end) && is_digit(*input))
+        {
+            input++;
+        }
+    }
+
+    *position = input;
+    return true;
+
+fail:
+    *position = input;
+    return false;
+}
+
+static cJSON_bool validate_literal(const unsigned char ** const position, const unsigned char * const end, const char * const literal)
+{
+    const unsigned char *input = *position;
+    size_t i = 0;
+
+    for (i = 0; literal[i] != '\0'; i++)
+    {
+        if ((input + i >= end) || (input[i] != (unsigned char)literal[i]))
+        {
+            *position = input + i;
+            return false;
+        }
+    }
+
+    *position = input + i;
+    return true;
+}
+
+typedef enum
+{
+    validate_value, /* a value has to come next */
+    validate_key, /* a key and ':' have to come next */
+    validate_next /* ',', the end of the enclosing array/object or the end of the text has to come next */
+} validate_state;
+
+CJSON_PUBLIC(cJSON_bool) cJSON_Validate(const char *json, size_t length, size_t *error_offset)
+{
+    /* one bit for every open array (0) or object (1) */
+    unsigned char objects[(CJSON_NESTING_LIMIT + 7) / 8];
+    size_t depth = 0;
+    validate_state state = validate_value;
+    const unsigned char *input = (const unsigned char*)json;
+    const unsigned char *end = NULL;
+
+    if (json == NULL)
+    {
+        if (error_offset != NULL)
+        {
+            *error_offset = 0;
+        }
+        return false;
+    }
+    end = input + length;
+
+    for (;;)
+    {
+        input = validate_skip_whitespace(input, end);
+
+        if (state == validate_next)
+        {
+            cJSON_bool in_object = false;
+
+            if (depth == 0)
+            {
+                if (input != end)
+                {
+                    goto fail;
+                }
+                return true;
+            }
+            if (input >= end)
+            {
+                goto fail;
+            }
+
+            in_object = is_object_at(objects, depth - 1);
+            if (*input == ',')
+            {
+                input++;
+                state = in_object ? validate_key : validate_value;
+            }
+            else if (*input == (in_object ? '}' : ']'))
+            {
+                input++;
+                depth--;
+            }
+            else
+            {
+                goto fail;
+            }
+            continue;
+        }
+
+        if (state == validate_key)
+        {
+            if ((input >= end) || (*input != '\"') || !validate_string(&input, end))
+            {
+                goto fail;
+            }
+            input = validate_skip_whitespace(input, end);
+            if ((input >= end) || (*input != ':'))
+            {
+                goto fail;
+            }
+            input++;
+            state = validate_value;
+            continue;
+        }
+
+        if (input >= end)
+        {
+            goto fail;
+        }
+        state = validate_next;
+        switch (*input)
+        {
+            case '{':
+            case '[':
+            {
+                cJSON_bool object = (*input == '{');
+
+                if (depth >= CJSON_NESTING_LIMIT)
+                {
+                    goto fail;
+                }
+                if (object)
+                {
+                    objects[depth / 8] = (unsigned char)(objects[depth / 8] | (1 << (depth % 8)));
+                }
+                else
+                {
+                    objects[depth / 8] = (unsigned char)(objects[depth / 8] & ~(1 << (depth % 8)));
+                }
+                depth++;
+
+                input = validate_skip_whitespace(input + 1, end);
+                if ((input < end) && (*input == (object ? '}' : ']')))
+                {
+                    /* empty array/object */
+                    input++;
+                    depth--;
+                }
+                else
+                {
+                    state = object ? validate_key : validate_value;
+                }
+                break;
+            }
+
+            case '\"':
+                if (!validate_string(&input, end))
+                {
+                    goto fail;
+                }
+                break;
+
+            case 't':
+                if (!validate_literal(&input, end, "true"))
+                {
+                    goto fail;
+                }
+                break;
+
+            case 'f':
+                if (!validate_literal(&input, end, "false"))
+                {
+                    goto fail;
+                }
+                break;
+
+            case 'n':
+                if (!validate_literal(&input, end, "null"))
+                {
+                    goto fail;
+                }
+                break;
+
+            default:
+                if (!validate_number(&input, end))
+                {
+                    goto fail;
+                }
+                break;
+        }
+    }
+
+fail:
+    if (error_offset != NULL)
+    {
+        *error_offset = (size_t)(input - (const unsigned char*)json);
+    }
+
+    return false;
+}
+
+/* Tapes, see cJSON_ParseTape. The items are appended in document order while parsing,
+ * an array or object gets its skip once its children are done. Strings are unescaped
+ * in place in a copy of the input, like with cJSON_ParseInSitu. */
+struct cJSON_Tape
+{
+    cJSON_TapeItem *items;
+    size_t count;
+    size_t capacity;
+    char *text; /* the copy of the input the strings point into */
+    internal_hooks hooks; /* what the tape was allocated with */
+};
+
+/* Append an empty item to the tape and return its position, growing the tape if needed. */
+static cJSON_bool tape_append(cJSON_Tape * const tape, size_t * const position)
+{
+    if (tape->count == tape->capacity)
+    {
+        cJSON_TapeItem *grown = NULL;
+        size_t capacity = tape->capacity * 2;
+
+        /* skip has to be able to span the whole tape */
+        if (capacity > UINT_MAX)
+        {
+            capacity = UINT_MAX;
+        }
+        if ((capacity <= tape->count) || (capacity > ((size_t)-1 / sizeof(cJSON_TapeItem))))
+        {
+            return false;
+        }
+
+        if (tape->hooks.reallocate != NULL)
+        {
+            grown = (cJSON_TapeItem*)tape->hooks.reallocate(tape->items, capacity * sizeof(cJSON_TapeItem));
+            if (grown == NULL)
+            {
+                return false;
+            }
         }
-        /* escape sequence */
         else
         {
-            unsigned char sequence_length = 2;
-            if ((input_end - input_pointer) < 1)
+            grown = (cJSON_TapeItem*)tape->hooks.allocate(capacity * sizeof(cJSON_TapeItem));
+            if (grown == NULL)
+            {
+                return false;
+            }
+            memcpy(grown, tape->items, tape->count * sizeof(cJSON_TapeItem));
+            tape->hooks.deallocate(tape->items);
+        }
+        tape->items = grown;
+        tape->capacity = capacity;
+    }
+
+    *position = tape->count++;
+    memset(&tape->items[*position], '\0', sizeof(cJSON_TapeItem));
+    tape->items[*position].skip = 1;
+
+    return true;
+}
+
+static cJSON_bool tape_parse_value(cJSON_Tape * const tape, parse_buffer * const input_buffer, const char * const key);
+
+/* Parse the children of the array or object at position. */
+static cJSON_bool tape_parse_children(cJSON_Tape * const tape, parse_buffer * const input_buffer, const size_t position)
+{
+    const cJSON_bool is_object = (buffer_at_offset(input_buffer)[0] == '{');
+    const unsigned char end = is_object ? '}' : ']';
+    cJSON key;
+
+    if (input_buffer->depth >= input_buffer->nesting_limit)
+    {
+        return false; /* to deeply nested */
+    }
+    input_buffer->depth++;
+
+    tape->items[position].type = is_object ? cJSON_Object : cJSON_Array;
+
+    input_buffer->offset++;
+    buffer_skip_whitespace(input_buffer);
+    if (cannot_access_at_index(input_buffer, 0))
+    {
+        return false;
+    }
+    if (buffer_at_offset(input_buffer)[0] != end)
+    {
+        /* step back to character in front of the first element */
+        input_buffer->offset--;
+        do
+        {
+            input_buffer->offset++;
+            buffer_skip_whitespace(input_buffer);
+            memset(&key, '\0', sizeof(key));
+            if (is_object)
+            {
+                if (!parse_string(&key, input_buffer))
+                {
+                    return false; /* failed to parse name */
+                }
+                buffer_skip_whitespace(input_buffer);
+                if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
+                {
+                    return false; /* invalid object */
+                }
+                input_buffer->offset++;
+                buffer_skip_whitespace(input_buffer);
+            }
+
+            if (!tape_parse_value(tape, input_buffer, key.valuestring))
+            {
+                return false;
+            }
+            buffer_skip_whitespace(input_buffer);
+        }
+        while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
+
+        if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != end))
+        {
+            return false; /* expected end of array/object */
+        }
+    }
+
+    input_buffer->depth--;
+    input_buffer->offset++;
+    tape->items[position].skip = (unsigned int)(tape->count - position);
+
+    return true;
+}
+
+static cJSON_bool tape_parse_value(cJSON_Tape * const tape, parse_buffer * const input_buffer, const char * const key)
+{
+    cJSON value;
+    size_t position = 0;
+
+    if (cannot_access_at_index(input_buffer, 0) || !tape_append(tape, &position))
+    {
+        return false;
+    }
+    tape->items[position].string = key;
+
+    switch (buffer_at_offset(input_buffer)[0])
+    {
+        case 'n':
+        case 'f':
+        case 't':
+            if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "null", 4) == 0))
+            {
+                tape->items[position].type = cJSON_NULL;
+                input_buffer->offset += 4;
+                return true;
+            }
+            if (can_read(input_buffer, 5) && (strncmp((const char*)buffer_at_offset(input_buffer), "false", 5) == 0))
+            {
+                tape->items[position].type = cJSON_False;
+                input_buffer->offset += 5;
+                return true;
+            }
+            if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "true", 4) == 0))
+            {
+                tape->items[position].type = cJSON_True;
+                input_buffer->offset += 4;
+                return true;
+            }
+            return false;
+
+        case '\"':
+            memset(&value, '\0', sizeof(value));
+            if (!parse_string(&value, input_buffer))
+            {
+                return false;
+            }
+            tape->items[position].type = cJSON_String;
+            tape->items[position].valuestring = value.valuestring;
+            return true;
+
+        case '[':
+        case '{':
+            return tape_parse_children(tape, input_buffer, position);
+
+        default:
+            memset(&value, '\0', sizeof(value));
+            if (!is_digit(buffer_at_offset(input_buffer)[0]) && (buffer_at_offset(input_buffer)[0] != '-'))
+            {
+                return false;
+            }
+            if (!parse_number(&value, input_buffer))
+            {
+                return false;
+            }
+            tape->items[position].type = cJSON_Number;
+            tape->items[position].valuedouble = value.valuedouble;
+            return true;
+    }
+}
+
+/* Like parse(), errors go to the context. */
+static cJSON_Tape *parse_tape(cJSON_Context * const context, const char *value, const char **return_parse_end, cJSON_bool require_null_terminated, const internal_hooks * const hooks)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0 }, 0, 0, 0, 0 };
+    cJSON_Tape *tape = NULL;
+    size_t length = 0;
+
+    /* reset error position */
+    context->error.json = NULL;
+    context->error.position = 0;
+
+    if (value == NULL)
+    {
+        return NULL;
+    }
+    length = strlen(value) + sizeof("");
+
+    tape = (cJSON_Tape*)hooks->allocate(sizeof(cJSON_Tape));
+    if (tape == NULL)
+    {
+        goto fail;
+    }
+    memset(tape, '\0', sizeof(cJSON_Tape));
+    tape->hooks = *hooks;
+
+    tape->text = (char*)hooks->allocate(length);
+    /* about one item per 8 bytes of input, it grows if needed */
+    tape->capacity = (length / 8) + 16;
+    tape->items = (cJSON_TapeItem*)hooks->allocate(tape->capacity * sizeof(cJSON_TapeItem));
+    if ((tape->text == NULL) || (tape->items == NULL))
+    {
+        goto fail;
+    }
+    memcpy(tape->text, value, length);
+
+    buffer.content = (const unsigned char*)tape->text;
+    buffer.length = length;
+    buffer.hooks = *hooks;
+    buffer.in_situ = (unsigned char*)tape->text;
+    buffer.nesting_limit = context->nesting_limit;
+
+    if (!tape_parse_value(tape, buffer_skip_whitespace(&buffer), NULL))
+    {
+        goto fail;
+    }
+
+    if (require_null_terminated)
+    {
+        buffer_skip_whitespace(&buffer);
+        if ((buffer.offset >= buffer.length) || buffer_at_offset(&buffer)[0] != '\0')
+        {
+            goto fail;
+        }
+    }
+    if (return_parse_end)
+    {
+        *return_parse_end = value + buffer.offset;
+    }
+
+    /* give back what the estimate left unused */
+    if ((tape->count < tape->capacity) && (hooks->reallocate != NULL))
+    {
+        cJSON_TapeItem *shrunk = (cJSON_TapeItem*)hooks->reallocate(tape->items, tape->count * sizeof(cJSON_TapeItem));
+        if (shrunk != NULL)
+        {
+            tape->items = shrunk;
+            tape->capacity = tape->count;
+        }
+    }
+
+    return tape;
+
+fail:
+    cJSON_DeleteTape(tape);
+
+    context->error.json = (const unsigned char*)value;
+    context->error.position = 0;
+    if (buffer.offset < buffer.length)
+    {
+        context->error.position = buffer.offset;
+    }
+    else if (buffer.length > 0)
+    {
+        context->error.position = buffer.length - 1;
+    }
+
+    if (return_parse_end != NULL)
+    {
+        *return_parse_end = (const char*)context->error.json + context->error.position;
+    }
+
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON_Tape *) cJSON_ParseTapeWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    cJSON_Context context;
+    cJSON_Tape *tape = NULL;
+
+    memset(&context, '\0', sizeof(context));
+    context.nesting_limit = CJSON_NESTING_LIMIT;
+
+    tape = parse_tape(&context, value, return_parse_end, require_null_terminated, &global_hooks);
+    if (return_parse_end == NULL)
+    {
+        global_error = context.error;
+    }
+    else
+    {
+        global_error.json = NULL;
+        global_error.position = 0;
+    }
+
+    return tape;
+}
+
+CJSON_PUBLIC(cJSON_Tape *) cJSON_ParseTape(const char *value)
+{
+    return cJSON_ParseTapeWithOpts(value, NULL, false);
+}
+
+CJSON_PUBLIC(cJSON_Tape *) cJSON_ParseTapeWithContext(cJSON_Context *context, const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    if (context == NULL)
+    {
+        return NULL;
+    }
+
+    return parse_tape(context, value, return_parse_end, require_null_terminated, &context->hooks);
+}
+
+CJSON_PUBLIC(void) cJSON_DeleteTape(cJSON_Tape *tape)
+{
+    if (tape == NULL)
+    {
+        return;
+    }
+
+    if (tape->items != NULL)
+    {
+        tape->hooks.deallocate(tape->items);
+    }
+    if (tape->text != NULL)
+    {
+        tape->hooks.deallocate(tape->text);
+    }
+    tape->hooks.deallocate(tape);
+}
+
+CJSON_PUBLIC(const cJSON_TapeItem *) cJSON_GetTapeRoot(const cJSON_Tape *tape)
+{
+    return (tape != NULL) ? tape->items : NULL;
+}
+
+CJSON_PUBLIC(int) cJSON_GetTapeArraySize(const cJSON_TapeItem *array)
+{
+    const cJSON_TapeItem *element = NULL;
+    int size = 0;
+
+    cJSON_TapeArrayForEach(element, array)
+    {
+        size++;
+    }
+
+    return size;
+}
+
+CJSON_PUBLIC(const cJSON_TapeItem *) cJSON_GetTapeArrayItem(const cJSON_TapeItem *array, int index)
+{
+    const cJSON_TapeItem *element = NULL;
+
+    if (index < 0)
+    {
+        return NULL;
+    }
+
+    cJSON_TapeArrayForEach(element, array)
+    {
+        if (index-- == 0)
+        {
+            return element;
+        }
+    }
+
+    return NULL;
+}
+
+static const cJSON_TapeItem *get_tape_object_item(const cJSON_TapeItem * const object, const char * const name, const cJSON_bool case_sensitive)
+{
+    const cJSON_TapeItem *element = NULL;
+
+    if ((object == NULL) || (name == NULL) || (object->type != cJSON_Object))
+    {
+        return NULL;
+    }
+
+    cJSON_TapeArrayForEach(element, object)
+    {
+        if (case_sensitive ? (strcmp(name, element->string) == 0) : (case_insensitive_strcmp((const unsigned char*)name, (const unsigned char*)element->string) == 0))
+        {
+            return element;
+        }
+    }
+
+    return NULL;
+}
+
+CJSON_PUBLIC(const cJSON_TapeItem *) cJSON_GetTapeObjectItem(const cJSON_TapeItem *object, const char *string)
+{
+    return get_tape_object_item(object, string, false);
+}
+
+CJSON_PUBLIC(const cJSON_TapeItem *) cJSON_GetTapeObjectItemCaseSensitive(const cJSON_TapeItem *object, const char *string)
+{
+    return get_tape_object_item(object, string, true);
+}
+
+/* Streaming parser: a pushdown automaton that is fed one chunk at a time. Only
+ * the string, number or literal that is being read and the key that goes with
+ * it are buffered, they are decoded with parse_string and parse_number once
+ * they are complete. */
+typedef enum
+{
+    stream_value, /* expecting a value */
+    stream_first_value, /* expecting a value or ']' right after '[' */
+    stream_first_key, /* expecting a key or '}' right after '{' */
+    stream_key, /* expecting a key after ',' */
+    stream_colon,
+    stream_separator, /* expecting ',' or the end of the array/object */
+    stream_string,
+    stream_key_string,
+    stream_number,
+    stream_literal,
+    stream_done, /* the document is complete, only whitespace may follow */
+    stream_error
+} stream_state;
+
+typedef struct
+{
+    unsigned char *data;
+    size_t length;
+    size_t capacity;
+} stream_buffer;
+
+struct cJSON_Stream
+{
+    cJSON_StreamHandler handler;
+    void *context;
+    internal_hooks hooks;
+    size_t nesting_limit;
+    stream_state state;
+    cJSON_bool escaped; /* in a string, the last byte was a backslash */
+    cJSON_bool has_key; /* key holds the key of the next value */
+    size_t offset; /* number of bytes consumed */
+    size_t depth;
+    stream_buffer containers; /* '[' or '{' for every open array/object */
+    stream_buffer token;
+    stream_buffer key;
+};
+
+static cJSON_bool stream_buffer_append(stream_buffer * const buffer, const unsigned char * const data, const size_t length, const internal_hooks * const hooks)
+{
+    if ((buffer->capacity - buffer->length) < length)
+    {
+        unsigned char *grown = NULL;
+        size_t capacity = (buffer->capacity < 64) ? 64 : buffer->capacity;
+
+        while ((capacity - buffer->length) < length)
+        {
+            if (capacity > ((size_t)-1 / 2))
             {
-                goto fail;
+                return false;
             }
+            capacity *= 2;
+        }
 
-            switch (input_pointer[1])
-            {
-                case 'b':
-                    *output_pointer++ = '\b';
-                    break;
-                case 'f':
-                    *output_pointer++ = '\f';
-                    break;
-                case 'n':
-                    *output_pointer++ = '\n';
-                    break;
-                case 'r':
-                    *output_pointer++ = '\r';
-                    break;
-                case 't':
-                    *output_pointer++ = '\t';
-                    break;
-                case '\"':
-                case '\\':
-                case '/':
-                    *output_pointer++ = input_pointer[1];
-                    break;
+        grown = (unsigned char*)hooks->allocate(capacity);
+        if (grown == NULL)
+        {
+            return false;
+        }
+        if (buffer->data != NULL)
+        {
+            memcpy(grown, buffer->data, buffer->length);
+            hooks->deallocate(buffer->data);
+        }
+        buffer->data = grown;
+        buffer->capacity = capacity;
+    }
 
-                /* UTF-16 literal */
-                case 'u':
-                    sequence_length = utf16_literal_to_utf8(input_pointer, input_end, &output_pointer);
-                    if (sequence_length == 0)
-                    {
-                        /* failed to convert UTF16-literal to UTF-8 */
-                        goto fail;
-                    }
-                    break;
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
 
-                default:
-                    goto fail;
-            }
-            input_pointer += sequence_length;
-        }
+    return true;
+}
+
+/* The stream keeps a copy of the hooks, it frees its buffers and itself with them. */
+static cJSON_Stream *create_stream(cJSON_StreamHandler handler, void *context, const internal_hooks * const hooks, size_t nesting_limit)
+{
+    cJSON_Stream *stream = NULL;
+
+    if (handler == NULL)
+    {
+        return NULL;
     }
 
-    /* zero terminate the output */
-    *output_pointer = '\0';
+    stream = (cJSON_Stream*)hooks->allocate(sizeof(cJSON_Stream));
+    if (stream == NULL)
+    {
+        return NULL;
+    }
+    memset(stream, '\0', sizeof(cJSON_Stream));
+    stream->handler = handler;
+    stream->context = context;
+    stream->hooks = *hooks;
+    stream->nesting_limit = nesting_limit;
+    stream->state = stream_value;
 
-    item->type = cJSON_String;
-    item->valuestring = (char*)output;
+    return stream;
+}
 
-    input_buffer->offset = (size_t) (input_end - input_buffer->content);
-    input_buffer->offset++;
+CJSON_PUBLIC(cJSON_Stream *) cJSON_CreateStream(cJSON_StreamHandler handler, void *context)
+{
+    return create_stream(handler, context, &global_hooks, CJSON_NESTING_LIMIT);
+}
+
+CJSON_PUBLIC(cJSON_Stream *) cJSON_CreateStreamWithContext(cJSON_Context *context, cJSON_StreamHandler handler, void *handler_context)
+{
+    if (context == NULL)
+    {
+        return NULL;
+    }
+
+    return create_stream(handler, handler_context, &context->hooks, context->nesting_limit);
+}
+
+CJSON_PUBLIC(void) cJSON_DeleteStream(cJSON_Stream *stream)
+{
+    if (stream == NULL)
+    {
+        return;
+    }
+
+    if (stream->containers.data != NULL)
+    {
+        stream->hooks.deallocate(stream->containers.data);
+    }
+    if (stream->token.data != NULL)
+    {
+        stream->hooks.deallocate(stream->token.data);
+    }
+    if (stream->key.data != NULL)
+    {
+        stream->hooks.deallocate(stream->key.data);
+    }
+    stream->hooks.deallocate(stream);
+}
+
+CJSON_PUBLIC(size_t) cJSON_StreamOffset(const cJSON_Stream *stream)
+{
+    return (stream != NULL) ? stream->offset : 0;
+}
+
+/* Pass an event to the handler, item gets the key if it has one. */
+static cJSON_bool stream_emit(cJSON_Stream * const stream, const cJSON_StreamEvent event, cJSON * const item)
+{
+    item->string = stream->has_key ? (char*)stream->key.data : NULL;
+    stream->has_key = false;
+
+    return stream->handler(stream->context, event, item, (int)stream->depth);
+}
+
+/* A value is complete, see what may come next. */
+static void stream_value_done(cJSON_Stream * const stream)
+{
+    stream->state = (stream->depth == 0) ? stream_done : stream_separator;
+}
+
+static cJSON_bool stream_begin(cJSON_Stream * const stream, const unsigned char container)
+{
+    cJSON item;
+
+    if (stream->depth >= stream->nesting_limit)
+    {
+        return false; /* too deeply nested */
+    }
+
+    memset(&item, '\0', sizeof(item));
+    item.type = (container == '[') ? cJSON_Array : cJSON_Object;
+    if (!stream_emit(stream, cJSON_StreamBegin, &item))
+    {
+        return false;
+    }
+
+    if (!stream_buffer_append(&stream->containers, &container, 1, &stream->hooks))
+    {
+        return false;
+    }
+    stream->depth++;
+    stream->state = (container == '[') ? stream_first_value : stream_first_key;
 
     return true;
+}
 
-fail:
-    if (output != NULL)
+static cJSON_bool stream_end(cJSON_Stream * const stream, const unsigned char container)
+{
+    cJSON item;
+
+    if ((stream->depth == 0) || (stream->containers.data[stream->depth - 1] != container))
     {
-        input_buffer->hooks.deallocate(output);
+        return false; /* doesn't match the open array/object */
     }
+    stream->depth--;
+    stream->containers.length--;
 
-    if (input_pointer != NULL)
+    memset(&item, '\0', sizeof(item));
+    item.type = (container == '[') ? cJSON_Array : cJSON_Object;
+    if (!stream_emit(stream, cJSON_StreamEnd, &item))
     {
-        input_buffer->offset = (size_t)(input_pointer - input_buffer->content);
+        return false;
     }
+    stream_value_done(stream);
 
-    return false;
+    return true;
 }
 
-/* Render the cstring provided to an escaped version that can be printed. */
-static cJSON_bool print_string_ptr(const unsigned char * const input, printbuffer * const output_buffer)
+/* The closing quote of a string or key was read, the token holds the whole literal including quotes. */
+static cJSON_bool stream_string_done(cJSON_Stream * const stream)
 {
-    const unsigned char *input_pointer = NULL;
-    unsigned char *output = NULL;
-    unsigned char *output_pointer = NULL;
-    size_t output_length = 0;
-    /* numbers of additional characters needed for escaping */
-    size_t escape_characters = 0;
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0 }, 0, 0, 0, 0 };
+    cJSON item;
 
-    if (output_buffer == NULL)
+    memset(&item, '\0', sizeof(item));
+    buffer.content = stream->token.data;
+    buffer.length = stream->token.length;
+    buffer.hooks = stream->hooks;
+    buffer.in_situ = stream->token.data;
+    if (!parse_string(&item, &buffer))
     {
         return false;
     }
 
-    /* empty string */
-    if (input == NULL)
+    if (stream->state == stream_key_string)
     {
-        output = ensure(output_buffer, sizeof("\"\""));
-        if (output == NULL)
+        stream->key.length = 0;
+        if (!stream_buffer_append(&stream->key, (const unsigned char*)item.valuestring, strlen(item.valuestring) + sizeof(""), &stream->hooks))
         {
             return false;
         }
-        strcpy((char*)output, "\"\"");
-
+        stream->has_key = true;
+        stream->state = stream_colon;
         return true;
     }
 
-    /* set "flag" to 1 if something needs to be escaped */
-    for (input_pointer = input; *input_pointer; input_pointer++)
+    item.type = cJSON_String;
+    if (!stream_emit(stream, cJSON_StreamValue, &item))
     {
-        switch (*input_pointer)
+        return false;
+    }
+    stream_value_done(stream);
+
+    return true;
+}
+
+/* A number or literal ended, i.e. the next byte doesn't belong to it anymore. */
+static cJSON_bool stream_scalar_done(cJSON_Stream * const stream)
+{
+    cJSON item;
+
+    memset(&item, '\0', sizeof(item));
+    if (stream->state == stream_number)
+    {
+        parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0 }, 0, 0, 0, 0 };
+
+        buffer.content = stream->token.data;
+        buffer.length = stream->token.length;
+        buffer.hooks = stream->hooks;
+        if (!parse_number(&item, &buffer) || (buffer.offset != buffer.length))
         {
-            case '\"':
-            case '\\':
-            case '\b':
-            case '\f':
-            case '\n':
-            case '\r':
-            case '\t':
-                /* one character escape sequence */
-                escape_characters++;
+            return false;
+        }
+    }
+    else if ((stream->token.length == 4) && (strncmp((const char*)stream->token.data, "null", 4) == 0))
+    {
+        item.type = cJSON_NULL;
+    }
+    else if ((stream->token.length == 4) && (strncmp((const char*)stream->token.data, "true", 4) == 0))
+    {
+        item.type = cJSON_True;
+        item.valueint = 1;
+    }
+    else if ((stream->token.length == 5) && (strncmp((const char*)stream->token.data, "false", 5) == 0))
+    {
+        item.type = cJSON_False;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (!stream_emit(stream, cJSON_StreamValue, &item))
+    {
+        return false;
+    }
+    stream_value_done(stream);
+
+    return true;
+}
+
+/* Handle a byte outside of strings, numbers and literals. */
+static cJSON_bool stream_structural(cJSON_Stream * const stream, const unsigned char c)
+{
+    switch (stream->state)
+    {
+        case stream_first_value:
+            if (c == ']')
+            {
+                return stream_end(stream, '[');
+            }
+            /* fall through */
+        case stream_value:
+            stream->token.length = 0;
+            switch (c)
+            {
+                case '[':
+                case '{':
+                    return stream_begin(stream, c);
+                case '\"':
+                    stream->state = stream_string;
+                    return stream_buffer_append(&stream->token, &c, 1, &stream->hooks);
+                case 't':
+                case 'f':
+                case 'n':
+                    stream->state = stream_literal;
+                    return stream_buffer_append(&stream->token, &c, 1, &stream->hooks);
+                default:
+                    if ((c == '-') || ((c >= '0') && (c <= '9')))
+                    {
+                        stream->state = stream_number;
+                        return stream_buffer_append(&stream->token, &c, 1, &stream->hooks);
+                    }
+                    return false;
+            }
+
+        case stream_first_key:
+            if (c == '}')
+            {
+                return stream_end(stream, '{');
+            }
+            /* fall through */
+        case stream_key:
+            if (c != '\"')
+            {
+                return false;
+            }
+            stream->token.length = 0;
+            stream->state = stream_key_string;
+            return stream_buffer_append(&stream->token, &c, 1, &stream->hooks);
+
+        case stream_colon:
+            if (c != ':')
+            {
+                return false;
+            }
+            stream->state = stream_value;
+            return true;
+
+        case stream_separator:
+            if (c == ',')
+            {
+                stream->state = (stream->containers.data[stream->depth - 1] == '{') ? stream_key : stream_value;
+                return true;
+            }
+            if ((c == ']') || (c == '}'))
+            {
+                return stream_end(stream, (c == ']') ? '[' : '{');
+            }
+            return false;
+
+        default:
+            /* stream_done: nothing but whitespace after the document */
+            return false;
+    }
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_StreamFeed(cJSON_Stream *stream, const char *chunk, size_t length)
+{
+    const unsigned char *input = (const unsigned char*)chunk;
+    const unsigned char *end = input + length;
+    const unsigned char *start = input;
+
+    if ((stream == NULL) || ((chunk == NULL) && (length > 0)) || (stream->state == stream_error))
+    {
+        return false;
+    }
+
+    while (input < end)
+    {
+        start = input;
+
+        switch (stream->state)
+        {
+            case stream_string:
+            case stream_key_string:
+                if (stream->escaped)
+                {
+                    /* the escaped byte can't end the string */
+                    stream->escaped = false;
+                    input++;
+                }
+                input = find_quote_or_backslash(input, end);
+                if (input == end)
+                {
+                    if (!stream_buffer_append(&stream->token, start, (size_t)(input - start), &stream->hooks))
+                    {
+                        goto fail;
+                    }
+                    break;
+                }
+                input++;
+                if (!stream_buffer_append(&stream->token, start, (size_t)(input - start), &stream->hooks))
+                {
+                    goto fail;
+                }
+                if (input[-1] == '\\')
+                {
+                    stream->escaped = true;
+                }
+                else if (!stream_string_done(stream))
+                {
+                    goto fail;
+                }
+                break;
+
+            case stream_number:
+            case stream_literal:
+                while ((input < end)
+                        && (((stream->state == stream_number) && (((*input >= '0') && (*input <= '9')) || (*input == '.') || (*input == '-') || (*input == '+') || (*input == 'e') || (*input == 'E')))
+                            || ((stream->state == stream_literal) && (*input >= 'a') && (*input <= 'z'))))
+                {
+                    input++;
+                }
+                if (!stream_buffer_append(&stream->token, start, (size_t)(input - start), &stream->hooks))
+                {
+                    goto fail;
+                }
+                if ((stream->state == stream_literal) && (stream->token.length > 5))
+                {
+                    goto fail;
+                }
+                /* the byte that ended it is handled in the next round */
+                if ((input < end) && !stream_scalar_done(stream))
+                {
+                    goto fail;
+                }
                 break;
+
             default:
-                if (*input_pointer < 32)
+                input = skip_whitespace(input, end);
+                if (input == end)
                 {
-                    /* UTF-16 escape sequence uXXXX */
-                    escape_characters += 5;
+                    break;
+                }
+                if (!stream_structural(stream, *input))
+                {
+                    goto fail;
                 }
+                input++;
                 break;
         }
-    }
-    output_length = (size_t)(input_pointer - input) + escape_characters;
-
-    output = ensure(output_buffer, output_length + sizeof("\"\""));
-    if (output == NULL)
-    {
-        return false;
-    }
-
-    /* no characters have to be escaped */
-    if (escape_characters == 0)
-    {
-        output[0] = '\"';
-        memcpy(output + 1, input, output_length);
-        output[output_length + 1] = '\"';
-        output[output_length + 2] = '\0';
-
-        return true;
-    }
 
-    output[0] = '\"';
-    output_pointer = output + 1;
-    /* copy the string */
-    for (input_pointer = input; *input_pointer != '\0'; (void)input_pointer++, output_pointer++)
-    {
-        if ((*input_pointer > 31) && (*input_pointer != '\"') && (*input_pointer != '\\'))
-        {
-            /* normal character, copy */
-            *output_pointer = *input_pointer;
-        }
-        else
-        {
-            /* character needs to be escaped */
-            *output_pointer++ = '\\';
-            switch (*input_pointer)
-            {
-                case '\\':
-                    *output_pointer = '\\';
-                    break;
-                case '\"':
-                    *output_pointer = '\"';
-                    break;
-                case '\b':
-                    *output_pointer = 'b';
-                    break;
-                case '\f':
-                    *output_pointer = 'f';
-                    break;
-                case '\n':
-                    *output_pointer = 'n';
-                    break;
-                case '\r':
-                    *output_pointer = 'r';
-                    break;
-                case '\t':
-                    *output_pointer = 't';
-                    break;
-                default:
-                    /* escape and print as unicode codepoint */
-                    sprintf((char*)output_pointer, "u%04x", *input_pointer);
-                    output_pointer += 4;
-                    break;
-            }
-        }
+        stream->offset += (size_t)(input - start);
     }
-    output[output_length + 1] = '\"';
-    output[output_length + 2] = '\0';
 
     return true;
-}
 
-/* Invoke print_string_ptr (which is useful) on an item. */
-static cJSON_bool print_string(const cJSON * const item, printbuffer * const p)
-{
-    return print_string_ptr((unsigned char*)item->valuestring, p);
+fail:
+    /* point at the offending byte */
+    stream->offset += (size_t)(input - start);
+    stream->state = stream_error;
+    return false;
 }
 
-/* Predeclare these prototypes. */
-static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer);
-static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_array(const cJSON * const item, printbuffer * const output_buffer);
-static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_object(const cJSON * const item, printbuffer * const output_buffer);
-
-/* Utility to jump whitespace and cr/lf */
-static parse_buffer *buffer_skip_whitespace(parse_buffer * const buffer)
+CJSON_PUBLIC(cJSON_bool) cJSON_StreamFinish(cJSON_Stream *stream)
 {
-    if ((buffer == NULL) || (buffer->content == NULL))
-    {
-        return NULL;
-    }
-
-    while (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] <= 32))
+    if (stream == NULL)
     {
-       buffer->offset++;
+        return false;
     }
 
-    if (buffer->offset == buffer->length)
+    /* a number or literal at the very end has nothing that ends it */
+    if (((stream->state == stream_number) || (stream->state == stream_literal)) && !stream_scalar_done(stream))
     {
-        buffer->offset--;
+        stream->state = stream_error;
     }
 
-    return buffer;
+    return stream->state == stream_done;
 }
 
-/* Parse an object - create a new root, and populate. */
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+/* Print through a buffer of CJSON_SINK_BUFFER_SIZE bytes that is handed to sink whenever it is full. */
+static cJSON_bool print_to_sink(const cJSON * const item, cJSON_bool format, cJSON_PrintSink sink, void *sink_context, const internal_hooks * const hooks)
 {
-    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
-    cJSON *item = NULL;
+    printbuffer buffer[1];
+    cJSON_bool success = false;
 
-    /* reset error position */
-    global_error.json = NULL;
-    global_error.position = 0;
+    memset(buffer, 0, sizeof(buffer));
 
-    if (value == NULL)
+    buffer->buffer = (unsigned char*) hooks->allocate(CJSON_SINK_BUFFER_SIZE);
+    buffer->length = CJSON_SINK_BUFFER_SIZE;
+    buffer->format = format;
+    buffer->hooks = *hooks;
+    buffer->sink = sink;
+    buffer->sink_context = sink_context;
+    if (buffer->buffer == NULL)
     {
-        goto fail;
+        return false;
     }
 
-    buffer.content = (const unsigned char*)value;
-    buffer.length = strlen((const char*)value) + sizeof("");
-    buffer.offset = 0;
-    buffer.hooks = global_hooks;
-
-    item = cJSON_New_Item(&global_hooks);
-    if (item == NULL) /* memory fail */
+    if (print_value(item, buffer))
     {
-        goto fail;
+        /* hand over the rest */
+        success = (buffer->offset == 0) || sink(sink_context, (const char*)buffer->buffer, buffer->offset);
     }
 
-    if (!parse_value(item, buffer_skip_whitespace(&buffer)))
+    if (buffer->buffer != NULL)
     {
-        /* parse failure. ep is set. */
-        goto fail;
+        hooks->deallocate(buffer->buffer);
     }
 
-    /* if we require null-terminated JSON without appended garbage, skip and then check for a null terminator */
-    if (require_null_terminated)
-    {
-        buffer_skip_whitespace(&buffer);
-        if ((buffer.offset >= buffer.length) || buffer_at_offset(&buffer)[0] != '\0')
-        {
-            goto fail;
-        }
-    }
-    if (return_parse_end)
-    {
-        *return_parse_end = (const char*)buffer_at_offset(&buffer);
-    }
+    return success;
+}
 
-    return item;
+/* Add the length of the text print_value would produce to *length, without printing it. */
+static cJSON_bool measure_value(const cJSON * const item, size_t depth, cJSON_bool format, size_t * const length)
+{
+    unsigned char number_buffer[26];
+    size_t string_length = 0;
+    const cJSON *child = NULL;
 
-fail:
-    if (item != NULL)
+    switch ((item->type) & 0xFF)
     {
-        cJSON_Delete(item);
-    }
+        case cJSON_NULL:
+        case cJSON_True:
+            *length += sizeof("null") - 1;
+            return true;
 
-    if (value != NULL)
-    {
-        error local_error;
-        local_error.json = (const unsigned char*)value;
-        local_error.position = 0;
+        case cJSON_False:
+            *length += sizeof("false") - 1;
+            return true;
 
-        if (buffer.offset < buffer.length)
-        {
-            local_error.position = buffer.offset;
-        }
-        else if (buffer.length > 0)
-        {
-            local_error.position = buffer.length - 1;
-        }
+        case cJSON_Number:
+            if ((item->valuedouble * 0) != 0)
+            {
+                *length += sizeof("null") - 1;
+            }
+            else
+            {
+                *length += (size_t)format_number(item->valuedouble, number_buffer);
+            }
+            return true;
 
-        if (return_parse_end != NULL)
-        {
-            *return_parse_end = (const char*)local_error.json + local_error.position;
-        }
-        else
-        {
-            global_error = local_error;
-        }
-    }
+        case cJSON_Raw:
+            if (item->valuestring == NULL)
+            {
+                return false;
+            }
+            *length += strlen(item->valuestring);
+            return true;
 
-    return NULL;
-}
+        case cJSON_String:
+            if (item->valuestring != NULL)
+            {
+                *length += count_escape_characters((const unsigned char*)item->valuestring, &string_length) + string_length;
+            }
+            *length += sizeof("\"\"") - 1;
+            return true;
 
-/* Default options for cJSON_Parse */
-CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value)
-{
-    return cJSON_ParseWithOpts(value, 0, 0);
-}
+        case cJSON_Array:
+            *length += sizeof("[]") - 1;
+            for (child = item->child; child != NULL; child = child->next)
+            {
+                if (!measure_value(child, depth + 1, format, length))
+                {
+                    return false;
+                }
+                if (child->next != NULL)
+                {
+                    *length += format ? 2 : 1; /* fmt: ", " */
+                }
+            }
+            return true;
+
+        case cJSON_Object:
+            *length += format ? (sizeof("{\n}") - 1 + depth) : (sizeof("{}") - 1);
+            for (child = item->child; child != NULL; child = child->next)
+            {
+                if (child->string != NULL)
+                {
+                    string_length = 0;
+                    *length += count_escape_characters((const unsigned char*)child->string, &string_length) + string_length;
+                }
+                *length += sizeof("\"\":") - 1;
+                if (format)
+                {
+                    *length += depth + 1 + sizeof("\t\n") - 1; /* indentation, then "\t" after the colon and "\n" after the value */
+                }
+                if (!measure_value(child, depth + 1, format, length))
+                {
+                    return false;
+                }
+                if (child->next != NULL)
+                {
+                    *length += 1; /* "," */
+                }
+            }
+            return true;
 
-#define cjson_min(a, b) ((a < b) ? a : b)
+        default:
+            return false;
+    }
+}
 
 static unsigned char *print(const cJSON * const item, cJSON_bool format, const internal_hooks * const hooks)
 {
@@ -1028,6 +4970,7 @@ static unsigned char *print(const cJSON * const item, cJSON_bool format, const i
 
     /* create buffer */
     buffer->buffer = (unsigned char*) hooks->allocate(256);
+    buffer->length = 256;
     buffer->format = format;
     buffer->hooks = *hooks;
     if (buffer->buffer == NULL)
@@ -1040,16 +4983,16 @@ static unsigned char *print(const cJSON * const item, cJSON_bool format, const i
     {
         goto fail;
     }
-    update_offset(buffer);
 
     /* check if reallocate is available */
     if (hooks->reallocate != NULL)
     {
-        printed = (unsigned char*) hooks->reallocate(buffer->buffer, buffer->length);
-        buffer->buffer = NULL;
+        /* shrink to fit */
+        printed = (unsigned char*) hooks->reallocate(buffer->buffer, buffer->offset + 1);
         if (printed == NULL) {
             goto fail;
         }
+        buffer->buffer = NULL;
     }
     else /* otherwise copy the JSON over to a new buffer */
     {
@@ -1058,8 +5001,7 @@ static unsigned char *print(const cJSON * const item, cJSON_bool format, const i
         {
             goto fail;
         }
-        memcpy(printed, buffer->buffer, cjson_min(buffer->length, buffer->offset + 1));
-        printed[buffer->offset] = '\0'; /* just to be sure */
+        memcpy(printed, buffer->buffer, buffer->offset + 1);
 
         /* free the buffer */
         hooks->deallocate(buffer->buffer);
@@ -1073,57 +5015,123 @@ fail:
         hooks->deallocate(buffer->buffer);
     }
 
-    if (printed != NULL)
+    return NULL;
+}
+
+/* Render a cJSON item/entity/structure to text. */
+CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item)
+{
+    return (char*)print(item, true, &global_hooks);
+}
+
+CJSON_PUBLIC(char *) cJSON_PrintUnformatted(const cJSON *item)
+{
+    return (char*)print(item, false, &global_hooks);
+}
+
+CJSON_PUBLIC(size_t) cJSON_PrintedLength(const cJSON *item, cJSON_bool fmt)
+{
+    size_t length = 0;
+
+    if ((item == NULL) || !measure_value(item, 0, fmt, &length))
+    {
+        return 0;
+    }
+
+    return length;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_PrintToSink(const cJSON *item, cJSON_PrintSink write_cb, void *context, cJSON_bool fmt)
+{
+    if ((item == NULL) || (write_cb == NULL))
+    {
+        return false;
+    }
+
+    return print_to_sink(item, fmt, write_cb, context, &global_hooks);
+}
+
+static char *print_buffered(const cJSON * const item, const int prebuffer, const cJSON_bool fmt, const internal_hooks * const hooks)
+{
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0, 0 }, 0, 0 };
+
+    if (prebuffer < 0)
+    {
+        return NULL;
+    }
+
+    p.buffer = (unsigned char*)hooks->allocate((size_t)prebuffer);
+    if (!p.buffer)
+    {
+        return NULL;
+    }
+
+    p.length = (size_t)prebuffer;
+    p.offset = 0;
+    p.noalloc = false;
+    p.format = fmt;
+    p.hooks = *hooks;
+
+    if (!print_value(item, &p))
     {
-        hooks->deallocate(printed);
+        if (p.buffer != NULL)
+        {
+            hooks->deallocate(p.buffer);
+        }
+        return NULL;
     }
 
-    return NULL;
+    return (char*)p.buffer;
 }
 
-/* Render a cJSON item/entity/structure to text. */
-CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item)
+CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON_bool fmt)
 {
-    return (char*)print(item, true, &global_hooks);
+    return print_buffered(item, prebuffer, fmt, &global_hooks);
 }
 
-CJSON_PUBLIC(char *) cJSON_PrintUnformatted(const cJSON *item)
+CJSON_PUBLIC(char *) cJSON_PrintWithContext(cJSON_Context *context, const cJSON *item)
 {
-    return (char*)print(item, false, &global_hooks);
+    if (context == NULL)
+    {
+        return NULL;
+    }
+
+    return (char*)print(item, true, &context->hooks);
 }
 
-CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON_bool fmt)
+CJSON_PUBLIC(char *) cJSON_PrintUnformattedWithContext(cJSON_Context *context, const cJSON *item)
 {
-    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
-
-    if (prebuffer < 0)
+    if (context == NULL)
     {
         return NULL;
     }
 
-    p.buffer = (unsigned char*)global_hooks.allocate((size_t)prebuffer);
-    if (!p.buffer)
+    return (char*)print(item, false, &context->hooks);
+}
+
+CJSON_PUBLIC(char *) cJSON_PrintBufferedWithContext(cJSON_Context *context, const cJSON *item, int prebuffer, cJSON_bool fmt)
+{
+    if (context == NULL)
     {
         return NULL;
     }
 
-    p.length = (size_t)prebuffer;
-    p.offset = 0;
-    p.noalloc = false;
-    p.format = fmt;
-    p.hooks = global_hooks;
+    return print_buffered(item, prebuffer, fmt, &context->hooks);
+}
 
-    if (!print_value(item, &p))
+CJSON_PUBLIC(cJSON_bool) cJSON_PrintToSinkWithContext(cJSON_Context *context, const cJSON *item, cJSON_PrintSink write_cb, void *sink_context, cJSON_bool fmt)
+{
+    if ((context == NULL) || (item == NULL) || (write_cb == NULL))
     {
-        return NULL;
+        return false;
     }
 
-    return (char*)p.buffer;
+    return print_to_sink(item, fmt, write_cb, sink_context, &context->hooks);
 }
 
 CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buf, const int len, const cJSON_bool fmt)
 {
-    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0, 0 }, 0, 0 };
 
     if (len < 0)
     {
@@ -1152,21 +5160,21 @@ static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buf
     /* null */
     if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "null", 4) == 0))
     {
-        item->type = cJSON_NULL;
+        set_item_type(item, cJSON_NULL);
         input_buffer->offset += 4;
         return true;
     }
     /* false */
     if (can_read(input_buffer, 5) && (strncmp((const char*)buffer_at_offset(input_buffer), "false", 5) == 0))
     {
-        item->type = cJSON_False;
+        set_item_type(item, cJSON_False);
         input_buffer->offset += 5;
         return true;
     }
     /* true */
     if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "true", 4) == 0))
     {
-        item->type = cJSON_True;
+        set_item_type(item, cJSON_True);
         item->valueint = 1;
         input_buffer->offset += 4;
         return true;
@@ -1209,30 +5217,33 @@ static cJSON_bool print_value(const cJSON * const item, printbuffer * const outp
     switch ((item->type) & 0xFF)
     {
         case cJSON_NULL:
-            output = ensure(output_buffer, 5);
+            output = ensure(output_buffer, sizeof("null") - 1);
             if (output == NULL)
             {
                 return false;
             }
             strcpy((char*)output, "null");
+            output_buffer->offset += sizeof("null") - 1;
             return true;
 
         case cJSON_False:
-            output = ensure(output_buffer, 6);
+            output = ensure(output_buffer, sizeof("false") - 1);
             if (output == NULL)
             {
                 return false;
             }
             strcpy((char*)output, "false");
+            output_buffer->offset += sizeof("false") - 1;
             return true;
 
         case cJSON_True:
-            output = ensure(output_buffer, 5);
+            output = ensure(output_buffer, sizeof("true") - 1);
             if (output == NULL)
             {
                 return false;
             }
             strcpy((char*)output, "true");
+            output_buffer->offset += sizeof("true") - 1;
             return true;
 
         case cJSON_Number:
@@ -1243,20 +5254,17 @@ static cJSON_bool print_value(const cJSON * const item, printbuffer * const outp
             size_t raw_length = 0;
             if (item->valuestring == NULL)
             {
-                if (!output_buffer->noalloc)
-                {
-                    output_buffer->hooks.deallocate(output_buffer->buffer);
-                }
                 return false;
             }
 
-            raw_length = strlen(item->valuestring) + sizeof("");
+            raw_length = strlen(item->valuestring);
             output = ensure(output_buffer, raw_length);
             if (output == NULL)
             {
                 return false;
             }
-            memcpy(output, item->valuestring, raw_length);
+            memcpy(output, item->valuestring, raw_length + sizeof(""));
+            output_buffer->offset += raw_length;
             return true;
         }
 
@@ -1280,7 +5288,7 @@ static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buf
     cJSON *head = NULL; /* head of the linked list */
     cJSON *current_item = NULL;
 
-    if (input_buffer->depth >= CJSON_NESTING_LIMIT)
+    if (input_buffer->depth >= input_buffer->nesting_limit)
     {
         return false; /* to deeply nested */
     }
@@ -1352,9 +5360,20 @@ static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buf
 success:
     input_buffer->depth--;
 
-    item->type = cJSON_Array;
+    if (head != NULL)
+    {
+        /* the first child's prev points to the last one */
+        head->prev = current_item;
+    }
+
+    set_item_type(item, cJSON_Array);
     item->child = head;
 
+    if ((input_buffer->flags & cJSON_ParseBuildIndex) && !index_build(item, table_hooks(input_buffer)))
+    {
+        return false;
+    }
+
     input_buffer->offset++;
 
     return true;
@@ -1362,7 +5381,7 @@ success:
 fail:
     if (head != NULL)
     {
-        cJSON_Delete(head);
+        delete_item(head, &input_buffer->hooks);
     }
 
     return false;
@@ -1398,11 +5417,10 @@ static cJSON_bool print_array(const cJSON * const item, printbuffer * const outp
         {
             return false;
         }
-        update_offset(output_buffer);
         if (current_element->next)
         {
             length = (size_t) (output_buffer->format ? 2 : 1);
-            output_pointer = ensure(output_buffer, length + 1);
+            output_pointer = ensure(output_buffer, length);
             if (output_pointer == NULL)
             {
                 return false;
@@ -1418,13 +5436,14 @@ static cJSON_bool print_array(const cJSON * const item, printbuffer * const outp
         current_element = current_element->next;
     }
 
-    output_pointer = ensure(output_buffer, 2);
+    output_pointer = ensure(output_buffer, 1);
     if (output_pointer == NULL)
     {
         return false;
     }
     *output_pointer++ = ']';
     *output_pointer = '\0';
+    output_buffer->offset++;
     output_buffer->depth--;
 
     return true;
@@ -1436,7 +5455,7 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
     cJSON *head = NULL; /* linked list head */
     cJSON *current_item = NULL;
 
-    if (input_buffer->depth >= CJSON_NESTING_LIMIT)
+    if (input_buffer->depth >= input_buffer->nesting_limit)
     {
         return false; /* to deeply nested */
     }
@@ -1490,15 +5509,30 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
         /* parse the name of the child */
         input_buffer->offset++;
         buffer_skip_whitespace(input_buffer);
-        if (!parse_string(current_item, input_buffer))
+        if (input_buffer->keys != NULL)
         {
-            goto fail; /* faile to parse name */
+            if (!parse_shared_key(current_item, input_buffer))
+            {
+                goto fail; /* faile to parse name */
+            }
         }
-        buffer_skip_whitespace(input_buffer);
+        else
+        {
+            if (!parse_string(current_item, input_buffer))
+            {
+                goto fail; /* faile to parse name */
+            }
 
-        /* swap valuestring and string, because we parsed the name */
-        current_item->string = current_item->valuestring;
-        current_item->valuestring = NULL;
+            /* swap valuestring and string, because we parsed the name */
+            current_item->string = current_item->valuestring;
+            current_item->valuestring = NULL;
+            if (input_buffer->in_situ != NULL)
+            {
+                /* the key points into the input, it must not be freed */
+                current_item->type |= cJSON_StringIsConst;
+            }
+        }
+        buffer_skip_whitespace(input_buffer);
 
         if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
         {
@@ -1524,16 +5558,31 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
 success:
     input_buffer->depth--;
 
-    item->type = cJSON_Object;
+    if (head != NULL)
+    {
+        /* the first child's prev points to the last one */
+        head->prev = current_item;
+    }
+
+    set_item_type(item, cJSON_Object);
     item->child = head;
 
+    if ((input_buffer->flags & cJSON_ParseBuildIndex) && !index_build(item, table_hooks(input_buffer)))
+    {
+        return false;
+    }
+    if ((input_buffer->flags & (cJSON_ParseBuildIndex | cJSON_ParseHashKeys)) && !key_table_build(item, table_hooks(input_buffer)))
+    {
+        return false;
+    }
+
     input_buffer->offset++;
     return true;
 
 fail:
     if (head != NULL)
     {
-        cJSON_Delete(head);
+        delete_item(head, &input_buffer->hooks);
     }
 
     return false;
@@ -1553,7 +5602,7 @@ static cJSON_bool print_object(const cJSON * const item, printbuffer * const out
 
     /* Compose the output: */
     length = (size_t) (output_buffer->format ? 2 : 1); /* fmt: {\n */
-    output_pointer = ensure(output_buffer, length + 1);
+    output_pointer = ensure(output_buffer, length);
     if (output_pointer == NULL)
     {
         return false;
@@ -1589,7 +5638,6 @@ static cJSON_bool print_object(const cJSON * const item, printbuffer * const out
         {
             return false;
         }
-        update_offset(output_buffer);
 
         length = (size_t) (output_buffer->format ? 2 : 1);
         output_pointer = ensure(output_buffer, length);
@@ -1609,11 +5657,10 @@ static cJSON_bool print_object(const cJSON * const item, printbuffer * const out
         {
             return false;
         }
-        update_offset(output_buffer);
 
         /* print comma if not last */
         length = (size_t) ((output_buffer->format ? 1 : 0) + (current_item->next ? 1 : 0));
-        output_pointer = ensure(output_buffer, length + 1);
+        output_pointer = ensure(output_buffer, length);
         if (output_pointer == NULL)
         {
             return false;
@@ -1633,7 +5680,8 @@ static cJSON_bool print_object(const cJSON * const item, printbuffer * const out
         current_item = current_item->next;
     }
 
-    output_pointer = ensure(output_buffer, output_buffer->format ? (output_buffer->depth + 1) : 2);
+    length = output_buffer->format ? output_buffer->depth : 1;
+    output_pointer = ensure(output_buffer, length);
     if (output_pointer == NULL)
     {
         return false;
@@ -1648,6 +5696,7 @@ static cJSON_bool print_object(const cJSON * const item, printbuffer * const out
     }
     *output_pointer++ = '}';
     *output_pointer = '\0';
+    output_buffer->offset += length;
     output_buffer->depth--;
 
     return true;
@@ -1658,6 +5707,12 @@ CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array)
 {
     cJSON *c = array->child;
     size_t i = 0;
+
+    if (array->index != NULL)
+    {
+        return (int)array->index->count;
+    }
+
     while(c)
     {
         i++;
@@ -1678,6 +5733,11 @@ static cJSON* get_array_item(const cJSON *array, size_t index)
         return NULL;
     }
 
+    if (array->index != NULL)
+    {
+        return (index < array->index->count) ? array->index->items[index] : NULL;
+    }
+
     current_child = array->child;
     while ((current_child != NULL) && (index > 0))
     {
@@ -1688,6 +5748,41 @@ static cJSON* get_array_item(const cJSON *array, size_t index)
     return current_child;
 }
 
+CJSON_PUBLIC(cJSON_bool) cJSON_BuildIndex(cJSON *item, cJSON_bool recurse)
+{
+    cJSON *child = NULL;
+
+    if ((item == NULL) || (item->type & cJSON_InArena))
+    {
+        return false;
+    }
+
+    if (((item->type & 0xFF) == cJSON_Array) || ((item->type & 0xFF) == cJSON_Object))
+    {
+        if (!index_build(item, &global_hooks))
+        {
+            return false;
+        }
+    }
+    if (((item->type & 0xFF) == cJSON_Object) && !key_table_build(item, &global_hooks))
+    {
+        return false;
+    }
+
+    if (recurse)
+    {
+        for (child = item->child; child != NULL; child = child->next)
+        {
+            if (child->child != NULL && !cJSON_BuildIndex(child, true))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
 CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index)
 {
     if (index < 0)
@@ -1698,29 +5793,77 @@ CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index)
     return get_array_item(array, (size_t)index);
 }
 
+static cJSON_bool key_equals(const char * const name, const cJSON * const item, const cJSON_bool case_sensitive)
+{
+    if (item->string == NULL)
+    {
+        return false;
+    }
+    if (name == item->string)
+    {
+        return true; /* e.g. the key of another item of a document parsed with cJSON_ParseInternKeys */
+    }
+    if (case_sensitive)
+    {
+        return strcmp(name, item->string) == 0;
+    }
+
+    return case_insensitive_strcmp((const unsigned char*)name, (const unsigned char*)(item->string)) == 0;
+}
+
 static cJSON *get_object_item(const cJSON * const object, const char * const name, const cJSON_bool case_sensitive)
 {
     cJSON *current_element = NULL;
+    const cJSON_KeyTable *table = NULL;
+    size_t visited = 0;
+    size_t hash = 0;
+    size_t position = 0;
 
     if ((object == NULL) || (name == NULL))
     {
         return NULL;
     }
 
-    current_element = object->child;
-    if (case_sensitive)
+    table = load_key_table(object);
+    if (table == NULL)
     {
-        while ((current_element != NULL) && (strcmp(name, current_element->string) != 0))
+        current_element = object->child;
+        while ((current_element != NULL) && !key_equals(name, current_element, case_sensitive))
         {
             current_element = current_element->next;
+            if (++visited == CJSON_HASH_THRESHOLD)
+            {
+                table = key_table_build_lazily(object);
+                if (table != NULL)
+                {
+                    break;
+                }
+            }
+        }
+        if (table == NULL)
+        {
+            return current_element;
         }
     }
-    else
+
+    /* all keys that match name are in the probe sequence of its hash */
+    current_element = NULL;
+    hash = hash_key((const unsigned char*)name);
+    for (position = hash & table->mask; table->slots[position].item != NULL; position = (position + 1) & table->mask)
     {
-        while ((current_element != NULL) && (case_insensitive_strcmp((const unsigned char*)name, (const unsigned char*)(current_element->string)) != 0))
+        if ((table->slots[position].hash != hash) || !key_equals(name, table->slots[position].item, case_sensitive))
         {
-            current_element = current_element->next;
+            continue;
+        }
+        if (current_element != NULL)
+        {
+            /* duplicate keys, the first one in the list wins */
+            for (current_element = object->child; !key_equals(name, current_element, case_sensitive); current_element = current_element->next)
+            {
+            }
+            break;
         }
+        current_element = table->slots[position].item;
     }
 
     return current_element;
@@ -1758,17 +5901,68 @@ static cJSON *create_reference(const cJSON *item, const internal_hooks * const h
     }
     memcpy(ref, item, sizeof(cJSON));
     ref->string = NULL;
-    ref->type |= cJSON_IsReference;
+    ref->index = NULL;
+    ref->keys = NULL;
+    /* the reference itself belongs to the hooks it was allocated from */
+    ref->type = (item->type & ~(cJSON_InArena | cJSON_ChildIsShared | cJSON_IsSharedChild)) | cJSON_IsReference | ((hooks->arena != NULL) ? cJSON_InArena : 0);
+    if (item->type & cJSON_ChildIsShared)
+    {
+        /* not a string, see shared_children */
+        ref->valuestring = NULL;
+    }
     ref->next = ref->prev = NULL;
     return ref;
 }
 
+/* Copy-on-write: give parent its own children before they change (see cJSON_Fork). If item is one of them, it is
+ * pointed to the same child in the new list. Returns false if parent can't be changed. */
+static cJSON_bool unshare_parent(cJSON * const parent, cJSON ** const item)
+{
+    cJSON *child = NULL;
+    size_t position = 0;
+
+    if (parent->type & cJSON_IsSharedChild)
+    {
+        return false;
+    }
+    if (!(parent->type & cJSON_ChildIsShared))
+    {
+        return true;
+    }
+
+    if (item != NULL)
+    {
+        for (child = parent->child; (child != NULL) && (child != *item); child = child->next)
+        {
+            position++;
+        }
+        if (child == NULL)
+        {
+            return false;
+        }
+    }
+    if (!cJSON_Unshare(parent))
+    {
+        return false;
+    }
+    if (item != NULL)
+    {
+        for (child = parent->child; position > 0; position--)
+        {
+            child = child->next;
+        }
+        *item = child;
+    }
+
+    return true;
+}
+
 /* Add item to array/object. */
 CJSON_PUBLIC(void) cJSON_AddItemToArray(cJSON *array, cJSON *item)
 {
     cJSON *child = NULL;
 
-    if ((item == NULL) || (array == NULL))
+    if ((item == NULL) || (array == NULL) || (item->type & cJSON_IsSharedChild) || !unshare_parent(array, NULL))
     {
         return;
     }
@@ -1779,16 +5973,29 @@ CJSON_PUBLIC(void) cJSON_AddItemToArray(cJSON *array, cJSON *item)
     {
         /* list is empty, start new one */
         array->child = item;
+        item->prev = item;
+        item->next = NULL;
     }
     else
     {
-        /* append to the end */
-        while (child->next)
+        /* append to the end, the first child's prev points to it */
+        if (child->prev != NULL)
         {
-            child = child->next;
+            child = child->prev;
+        }
+        else
+        {
+            /* the list was put together by hand, find the end */
+            while (child->next)
+            {
+                child = child->next;
+            }
         }
         suffix_object(child, item);
+        array->child->prev = item;
     }
+    index_append(array, item);
+    key_table_add(array, item);
 }
 
 CJSON_PUBLIC(void) cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item)
@@ -1813,18 +6020,35 @@ CJSON_PUBLIC(void) cJSON_AddItemToObjectCS(cJSON *object, const char *string, cJ
     {
         return;
     }
-    if (!(item->type & cJSON_StringIsConst) && item->string)
-    {
-        global_hooks.deallocate(item->string);
-    }
+    release_key(item, &global_hooks);
     item->string = (char*)string;
-    item->type |= cJSON_StringIsConst;
+    item->type = (item->type & ~cJSON_KeyIsShared) | cJSON_StringIsConst;
     cJSON_AddItemToArray(object, item);
 }
 #if defined (__clang__) || ((__GNUC__)  && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ > 5))))
     #pragma GCC diagnostic pop
 #endif
 
+CJSON_PUBLIC(void) cJSON_ArenaAddItemToObject(cJSON_Arena *arena, cJSON *object, const char *string, cJSON *item)
+{
+    internal_hooks hooks;
+    char *key = NULL;
+
+    if ((arena == NULL) || (item == NULL))
+    {
+        return;
+    }
+
+    /* the key lives in the arena too, so it is never freed on its own */
+    hooks = arena_hooks(arena);
+    key = (char*)cJSON_strdup((const unsigned char*)string, &hooks);
+    if (key == NULL)
+    {
+        return;
+    }
+    cJSON_AddItemToObjectCS(object, key, item);
+}
+
 CJSON_PUBLIC(void) cJSON_AddItemReferenceToArray(cJSON *array, cJSON *item)
 {
     cJSON_AddItemToArray(array, create_reference(item, &global_hooks));
@@ -1837,32 +6061,41 @@ CJSON_PUBLIC(void) cJSON_AddItemReferenceToObject(cJSON *object, const char *str
 
 CJSON_PUBLIC(cJSON *) cJSON_DetachItemViaPointer(cJSON *parent, cJSON * const item)
 {
-    if ((parent == NULL) || (item == NULL))
+    cJSON *child = item;
+
+    if ((parent == NULL) || (child == NULL) || !unshare_parent(parent, &child))
     {
         return NULL;
     }
 
-    if (item->prev != NULL)
+    if ((child != parent->child) && (child->prev != NULL))
     {
         /* not the first element */
-        item->prev->next = item->next;
+        child->prev->next = child->next;
     }
-    if (item->next != NULL)
+    if (child->next != NULL)
     {
         /* not the last element */
-        item->next->prev = item->prev;
+        child->next->prev = child->prev;
     }
 
-    if (item == parent->child)
+    if (child == parent->child)
     {
         /* first element */
-        parent->child = item->next;
+        parent->child = child->next;
+    }
+    else if ((child->next == NULL) && (parent->child->prev == child))
+    {
+        /* last element, the first one has to point to the new end */
+        parent->child->prev = child->prev;
     }
+    index_free(parent);
+    key_table_remove(parent, child);
     /* make sure the detached item doesn't point anywhere anymore */
-    item->prev = NULL;
-    item->next = NULL;
+    child->prev = NULL;
+    child->next = NULL;
 
-    return item;
+    return child;
 }
 
 CJSON_PUBLIC(cJSON *) cJSON_DetachItemFromArray(cJSON *array, int which)
@@ -1909,7 +6142,7 @@ CJSON_PUBLIC(void) cJSON_InsertItemInArray(cJSON *array, int which, cJSON *newit
 {
     cJSON *after_inserted = NULL;
 
-    if (which < 0)
+    if ((which < 0) || (array == NULL) || (newitem == NULL) || (newitem->type & cJSON_IsSharedChild) || !unshare_parent(array, NULL))
     {
         return;
     }
@@ -1932,39 +6165,61 @@ CJSON_PUBLIC(void) cJSON_InsertItemInArray(cJSON *array, int which, cJSON *newit
     {
         newitem->prev->next = newitem;
     }
+    index_free(array);
+    key_table_add(array, newitem);
 }
 
 CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemViaPointer(cJSON * const parent, cJSON * const item, cJSON * replacement)
 {
-    if ((parent == NULL) || (replacement == NULL))
+    cJSON *child = item;
+
+    if ((parent == NULL) || (child == NULL) || (replacement == NULL) || (replacement->type & cJSON_IsSharedChild))
     {
         return false;
     }
-
-    if (replacement == item)
+    if (replacement == child)
     {
         return true;
     }
+    if (!unshare_parent(parent, &child))
+    {
+        return false;
+    }
 
-    replacement->next = item->next;
-    replacement->prev = item->prev;
+    replacement->next = child->next;
+    replacement->prev = child->prev;
 
     if (replacement->next != NULL)
     {
         replacement->next->prev = replacement;
     }
-    if (replacement->prev != NULL)
+    if (parent->child == child)
     {
-        replacement->prev->next = replacement;
+        if (child->prev == child)
+        {
+            /* the only element points to itself */
+            replacement->prev = replacement;
+        }
+        parent->child = replacement;
     }
-    if (parent->child == item)
+    else
     {
-        parent->child = replacement;
+        if (replacement->prev != NULL)
+        {
+            replacement->prev->next = replacement;
+        }
+        if ((replacement->next == NULL) && (parent->child->prev == child))
+        {
+            parent->child->prev = replacement;
+        }
     }
+    index_free(parent);
+    key_table_remove(parent, child);
+    key_table_add(parent, replacement);
 
-    item->next = NULL;
-    item->prev = NULL;
-    cJSON_Delete(item);
+    child->next = NULL;
+    child->prev = NULL;
+    cJSON_Delete(child);
 
     return true;
 }
@@ -1979,67 +6234,69 @@ CJSON_PUBLIC(void) cJSON_ReplaceItemInArray(cJSON *array, int which, cJSON *newi
     cJSON_ReplaceItemViaPointer(array, get_array_item(array, (size_t)which), newitem);
 }
 
-CJSON_PUBLIC(void) cJSON_ReplaceItemInObject(cJSON *object, const char *string, cJSON *newitem)
-{
-    cJSON_ReplaceItemViaPointer(object, cJSON_GetObjectItem(object, string), newitem);
-}
-
-CJSON_PUBLIC(void) cJSON_ReplaceItemInObjectCaseSensitive(cJSON *object, const char *string, cJSON *newitem)
+static cJSON_bool replace_item_in_object(cJSON *object, const char *string, cJSON *replacement, cJSON_bool case_sensitive)
 {
-    cJSON_ReplaceItemViaPointer(object, cJSON_GetObjectItemCaseSensitive(object, string), newitem);
-}
+    cJSON *item = NULL;
 
-/* Create basic types: */
-CJSON_PUBLIC(cJSON *) cJSON_CreateNull(void)
-{
-    cJSON *item = cJSON_New_Item(&global_hooks);
-    if(item)
+    if ((replacement == NULL) || (string == NULL))
     {
-        item->type = cJSON_NULL;
+        return false;
     }
 
-    return item;
-}
+    item = get_object_item(object, string, case_sensitive);
+    if (item == NULL)
+    {
+        return false;
+    }
 
-CJSON_PUBLIC(cJSON *) cJSON_CreateTrue(void)
-{
-    cJSON *item = cJSON_New_Item(&global_hooks);
-    if(item)
+    /* the replacement takes over the key, so it can be found (and hashed) under it */
+    if (!(replacement->type & cJSON_InArena))
+    {
+        char *key = (char*)cJSON_strdup((const unsigned char*)string, &global_hooks);
+        if (key == NULL)
+        {
+            return false;
+        }
+        release_key(replacement, &global_hooks);
+        replacement->string = key;
+        replacement->type &= ~(cJSON_StringIsConst | cJSON_KeyIsShared);
+    }
+    else if (item->type & cJSON_InArena)
     {
-        item->type = cJSON_True;
+        /* both live in an arena, so does the key */
+        replacement->string = item->string;
     }
 
-    return item;
+    return cJSON_ReplaceItemViaPointer(object, item, replacement);
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_CreateFalse(void)
+CJSON_PUBLIC(void) cJSON_ReplaceItemInObject(cJSON *object, const char *string, cJSON *newitem)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
-    if(item)
-    {
-        item->type = cJSON_False;
-    }
+    replace_item_in_object(object, string, newitem, false);
+}
 
-    return item;
+CJSON_PUBLIC(void) cJSON_ReplaceItemInObjectCaseSensitive(cJSON *object, const char *string, cJSON *newitem)
+{
+    replace_item_in_object(object, string, newitem, true);
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_CreateBool(cJSON_bool b)
+/* Create basic types: */
+static cJSON *create_item(int type, const internal_hooks * const hooks)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
-    if(item)
+    cJSON *item = cJSON_New_Item(hooks);
+    if (item)
     {
-        item->type = b ? cJSON_True : cJSON_False;
+        set_item_type(item, type);
     }
 
     return item;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_CreateNumber(double num)
+static cJSON *create_number(double num, const internal_hooks * const hooks)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
+    cJSON *item = create_item(cJSON_Number, hooks);
     if(item)
     {
-        item->type = cJSON_Number;
         item->valuedouble = num;
 
         /* use saturation in case of overflow */
@@ -2051,39 +6308,22 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateNumber(double num)
         {
             item->valueint = INT_MIN;
         }
-        else
-        {
-            item->valueint = (int)num;
-        }
-    }
-
-    return item;
-}
-
-CJSON_PUBLIC(cJSON *) cJSON_CreateString(const char *string)
-{
-    cJSON *item = cJSON_New_Item(&global_hooks);
-    if(item)
-    {
-        item->type = cJSON_String;
-        item->valuestring = (char*)cJSON_strdup((const unsigned char*)string, &global_hooks);
-        if(!item->valuestring)
+        else
         {
-            cJSON_Delete(item);
-            return NULL;
+            item->valueint = (int)num;
         }
     }
 
     return item;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_CreateRaw(const char *raw)
+/* create a cJSON_String or cJSON_Raw item holding a copy of string */
+static cJSON *create_string(int type, const char *string, const internal_hooks * const hooks)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
+    cJSON *item = create_item(type, hooks);
     if(item)
     {
-        item->type = cJSON_Raw;
-        item->valuestring = (char*)cJSON_strdup((const unsigned char*)raw, &global_hooks);
+        item->valuestring = (char*)cJSON_strdup((const unsigned char*)string, hooks);
         if(!item->valuestring)
         {
             cJSON_Delete(item);
@@ -2094,26 +6334,104 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateRaw(const char *raw)
     return item;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_CreateArray(void)
+CJSON_PUBLIC(cJSON *) cJSON_CreateNull(void)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
-    if(item)
-    {
-        item->type=cJSON_Array;
-    }
+    return create_item(cJSON_NULL, &global_hooks);
+}
 
-    return item;
+CJSON_PUBLIC(cJSON *) cJSON_CreateTrue(void)
+{
+    return create_item(cJSON_True, &global_hooks);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateFalse(void)
+{
+    return create_item(cJSON_False, &global_hooks);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateBool(cJSON_bool b)
+{
+    return create_item(b ? cJSON_True : cJSON_False, &global_hooks);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateNumber(double num)
+{
+    return create_number(num, &global_hooks);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateString(const char *string)
+{
+    return create_string(cJSON_String, string, &global_hooks);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateRaw(const char *raw)
+{
+    return create_string(cJSON_Raw, raw, &global_hooks);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateArray(void)
+{
+    return create_item(cJSON_Array, &global_hooks);
 }
 
 CJSON_PUBLIC(cJSON *) cJSON_CreateObject(void)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
-    if (item)
-    {
-        item->type = cJSON_Object;
-    }
+    return create_item(cJSON_Object, &global_hooks);
+}
 
-    return item;
+/* Create basic types in an arena: */
+CJSON_PUBLIC(cJSON *) cJSON_ArenaCreateNull(cJSON_Arena *arena)
+{
+    internal_hooks hooks = arena_hooks(arena);
+    return (arena != NULL) ? create_item(cJSON_NULL, &hooks) : NULL;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ArenaCreateTrue(cJSON_Arena *arena)
+{
+    internal_hooks hooks = arena_hooks(arena);
+    return (arena != NULL) ? create_item(cJSON_True, &hooks) : NULL;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ArenaCreateFalse(cJSON_Arena *arena)
+{
+    internal_hooks hooks = arena_hooks(arena);
+    return (arena != NULL) ? create_item(cJSON_False, &hooks) : NULL;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ArenaCreateBool(cJSON_Arena *arena, cJSON_bool boolean)
+{
+    internal_hooks hooks = arena_hooks(arena);
+    return (arena != NULL) ? create_item(boolean ? cJSON_True : cJSON_False, &hooks) : NULL;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ArenaCreateNumber(cJSON_Arena *arena, double num)
+{
+    internal_hooks hooks = arena_hooks(arena);
+    return (arena != NULL) ? create_number(num, &hooks) : NULL;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ArenaCreateString(cJSON_Arena *arena, const char *string)
+{
+    internal_hooks hooks = arena_hooks(arena);
+    return (arena != NULL) ? create_string(cJSON_String, string, &hooks) : NULL;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ArenaCreateRaw(cJSON_Arena *arena, const char *raw)
+{
+    internal_hooks hooks = arena_hooks(arena);
+    return (arena != NULL) ? create_string(cJSON_Raw, raw, &hooks) : NULL;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ArenaCreateArray(cJSON_Arena *arena)
+{
+    internal_hooks hooks = arena_hooks(arena);
+    return (arena != NULL) ? create_item(cJSON_Array, &hooks) : NULL;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ArenaCreateObject(cJSON_Arena *arena)
+{
+    internal_hooks hooks = arena_hooks(arena);
+    return (arena != NULL) ? create_item(cJSON_Object, &hooks) : NULL;
 }
 
 /* Create Arrays: */
@@ -2149,6 +6467,11 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateIntArray(const int *numbers, int count)
         p = n;
     }
 
+    if (a && a->child)
+    {
+        a->child->prev = n;
+    }
+
     return a;
 }
 
@@ -2185,6 +6508,11 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateFloatArray(const float *numbers, int count)
         p = n;
     }
 
+    if (a && a->child)
+    {
+        a->child->prev = n;
+    }
+
     return a;
 }
 
@@ -2221,6 +6549,11 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateDoubleArray(const double *numbers, int count)
         p = n;
     }
 
+    if (a && a->child)
+    {
+        a->child->prev = n;
+    }
+
     return a;
 }
 
@@ -2257,6 +6590,11 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateStringArray(const char **strings, int count)
         p = n;
     }
 
+    if (a && a->child)
+    {
+        a->child->prev = n;
+    }
+
     return a;
 }
 
@@ -2280,10 +6618,10 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
         goto fail;
     }
     /* Copy over all vars */
-    newitem->type = item->type & (~cJSON_IsReference);
+    newitem->type = item->type & (~(cJSON_IsReference | cJSON_InArena | cJSON_InSitu | cJSON_ChildIsShared | cJSON_IsSharedChild));
     newitem->valueint = item->valueint;
     newitem->valuedouble = item->valuedouble;
-    if (item->valuestring)
+    if ((item->valuestring != NULL) && !(item->type & cJSON_ChildIsShared))
     {
         newitem->valuestring = (char*)cJSON_strdup((unsigned char*)item->valuestring, &global_hooks);
         if (!newitem->valuestring)
@@ -2293,7 +6631,21 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
     }
     if (item->string)
     {
-        newitem->string = (item->type&cJSON_StringIsConst) ? item->string : (char*)cJSON_strdup((unsigned char*)item->string, &global_hooks);
+        if ((item->type & cJSON_StringIsConst) && !(item->type & (cJSON_InArena | cJSON_InSitu)))
+        {
+            newitem->string = item->string;
+        }
+        else if ((item->type & cJSON_KeyIsShared) && !(item->type & cJSON_InArena))
+        {
+            shared_key_retain(item->string);
+            newitem->string = item->string;
+        }
+        else
+        {
+            /* keys in an arena or a parsed buffer don't outlive it, the copy gets its own */
+            newitem->string = (char*)cJSON_strdup((unsigned char*)item->string, &global_hooks);
+            newitem->type &= ~(cJSON_StringIsConst | cJSON_KeyIsShared);
+        }
         if (!newitem->string)
         {
             goto fail;
@@ -2328,6 +6680,10 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
         }
         child = child->next;
     }
+    if (newitem->child != NULL)
+    {
+        newitem->child->prev = next;
+    }
 
     return newitem;
 
@@ -2340,6 +6696,146 @@ fail:
     return NULL;
 }
 
+/* Turn the children of item, and everything below them, into shared children with one reference. */
+static cJSON_bool share_children(cJSON * const item)
+{
+    shared_children *shared = NULL;
+    cJSON *child = NULL;
+
+    if ((item->child == NULL) || (item->type & cJSON_ChildIsShared))
+    {
+        return true;
+    }
+    if (item->type & (cJSON_IsReference | cJSON_InArena))
+    {
+        return false;
+    }
+
+    /* bottom up, so the children of shared children are always shared, too */
+    for (child = item->child; child != NULL; child = child->next)
+    {
+        if ((child->type & cJSON_InArena) || !share_children(child))
+        {
+            return false;
+        }
+    }
+
+    shared = (shared_children*)global_hooks.allocate(sizeof(shared_children));
+    if (shared == NULL)
+    {
+        return false;
+    }
+    shared->references = 1;
+
+    item->valuestring = (char*)shared;
+    item->type |= cJSON_ChildIsShared;
+    for (child = item->child; child != NULL; child = child->next)
+    {
+        child->type |= cJSON_IsSharedChild;
+    }
+
+    return true;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_Fork(cJSON *item)
+{
+    cJSON *fork = NULL;
+
+    if ((item == NULL) || (item->type & cJSON_InArena) || !share_children(item))
+    {
+        return NULL;
+    }
+
+    fork = cJSON_Duplicate(item, false);
+    if (fork == NULL)
+    {
+        return NULL;
+    }
+    if (item->child != NULL)
+    {
+        shared_children_retain(shared_children_of(item));
+        fork->child = item->child;
+        fork->valuestring = item->valuestring;
+        fork->type |= cJSON_ChildIsShared;
+    }
+
+    return fork;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_Unshare(cJSON *item)
+{
+    shared_children *shared = NULL;
+    cJSON *head = NULL;
+    cJSON *child = NULL;
+    cJSON *copy = NULL;
+    cJSON *last = NULL;
+
+    if ((item == NULL) || (item->type & cJSON_IsSharedChild))
+    {
+        return false;
+    }
+    if (!(item->type & cJSON_ChildIsShared))
+    {
+        return true;
+    }
+
+    shared = shared_children_of(item);
+    if (shared_children_count(shared) == 1)
+    {
+        /* nobody else uses them, take them over */
+        global_hooks.deallocate(shared);
+        item->valuestring = NULL;
+        item->type &= ~cJSON_ChildIsShared;
+        for (child = item->child; child != NULL; child = child->next)
+        {
+            child->type &= ~cJSON_IsSharedChild;
+        }
+        return true;
+    }
+
+    /* copy the children, but not theirs */
+    head = item->child;
+    item->child = NULL;
+    for (child = head; child != NULL; child = child->next)
+    {
+        copy = cJSON_Duplicate(child, false);
+        if (copy == NULL)
+        {
+            delete_item(item->child, &global_hooks);
+            item->child = head;
+            return false;
+        }
+        if (child->type & cJSON_ChildIsShared)
+        {
+            shared_children_retain(shared_children_of(child));
+            copy->child = child->child;
+            copy->valuestring = child->valuestring;
+            copy->type |= cJSON_ChildIsShared;
+        }
+
+        if (last == NULL)
+        {
+            item->child = copy;
+        }
+        else
+        {
+            suffix_object(last, copy);
+        }
+        last = copy;
+    }
+    item->child->prev = last;
+
+    index_free(item);
+    key_table_free(item);
+    item->valuestring = NULL;
+    item->type &= ~cJSON_ChildIsShared;
+
+    /* the other users might have let go in the meantime */
+    release_shared_children(head, shared, &global_hooks);
+
+    return true;
+}
+
 CJSON_PUBLIC(void) cJSON_Minify(char *json)
 {
     unsigned char *into = (unsigned char*)json;
@@ -2504,6 +7000,22 @@ CJSON_PUBLIC(cJSON_bool) cJSON_IsRaw(const cJSON * const item)
     return (item->type & 0xFF) == cJSON_Raw;
 }
 
+static size_t count_members(const cJSON * const object, const char * const name, const cJSON_bool case_sensitive)
+{
+    const cJSON *member = NULL;
+    size_t count = 0;
+
+    for (member = object->child; member != NULL; member = member->next)
+    {
+        if (key_equals(name, member, case_sensitive))
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
 CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * const b, const cJSON_bool case_sensitive)
 {
     if ((a == NULL) || (b == NULL) || ((a->type & 0xFF) != (b->type & 0xFF)) || cJSON_IsInvalid(a))
@@ -2534,6 +7046,12 @@ CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * cons
         return true;
     }
 
+    /* so are arrays and objects with the same children, e.g. forks, see cJSON_Fork */
+    if ((a->type & (cJSON_Array | cJSON_Object)) && (a->child == b->child))
+    {
+        return true;
+    }
+
     switch (a->type & 0xFF)
     {
         /* in these cases and equal type is enough */
@@ -2576,22 +7094,82 @@ CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * cons
                 }
             }
 
-            return true;
+            /* one array is longer */
+            return (a_element == NULL) && (b_element == NULL);
         }
 
         case cJSON_Object:
         {
             cJSON *a_element = NULL;
-            cJSON_ArrayForEach(a_element, a)
+            cJSON *b_element = NULL;
+            cJSON_bool reordered = false;
+            cJSON_bool duplicates = false;
+            /* Two versions of a document usually list the keys in the same order, so the member
+             * at the same position is tried first. Other keys are looked up, which is O(1) for
+             * big objects thanks to their key table. */
+            for (a_element = a->child, b_element = b->child;
+                    (a_element != NULL) && (b_element != NULL);
+                    a_element = a_element->next, b_element = b_element->next)
             {
-                /* TODO This has O(n^2) runtime, which is horrible! */
-                cJSON *b_element = get_object_item(b, a_element->string, case_sensitive);
-                if (b_element == NULL)
+                cJSON *match = b_element;
+
+                if (a_element->string == NULL)
                 {
                     return false;
                 }
+                if (!key_equals(a_element->string, b_element, case_sensitive))
+                {
+                    match = get_object_item(b, a_element->string, case_sensitive);
+                    if (match == NULL)
+                    {
+                        return false;
+                    }
+                    reordered = true;
+                }
 
-                if (!cJSON_Compare(a_element, b_element, case_sensitive))
+                if (!cJSON_Compare(a_element, match, case_sensitive))
+                {
+                    return false;
+                }
+            }
+
+            /* not as many members in both objects */
+            if ((a_element != NULL) || (b_element != NULL))
+            {
+                return false;
+            }
+            /* pairwise equal */
+            if (!reordered)
+            {
+                return true;
+            }
+
+            /* lookups only find one member per key, so check the other way round, too */
+            for (b_element = b->child; b_element != NULL; b_element = b_element->next)
+            {
+                cJSON *match = NULL;
+
+                if (b_element->string == NULL)
+                {
+                    return false;
+                }
+                match = get_object_item(a, b_element->string, case_sensitive);
+                if ((match == NULL) || !cJSON_Compare(match, b_element, case_sensitive))
+                {
+                    return false;
+                }
+                if (get_object_item(b, b_element->string, case_sensitive) != b_element)
+                {
+                    duplicates = true;
+                }
+            }
+
+            /* now every member of either has an equal one with the same key in the other, so keys that
+             * occur more than once have to occur equally often: {"x":1,"x":1,"y":2} is not equal to
+             * {"x":1,"y":2,"y":2}. If b has no duplicate keys, neither has a. */
+            for (a_element = a->child; duplicates && (a_element != NULL); a_element = a_element->next)
+            {
+                if (count_members(a, a_element->string, case_sensitive) != count_members(b, a_element->string, case_sensitive))
                 {
                     return false;
                 }
@@ -2605,6 +7183,85 @@ CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * cons
     }
 }
 
+/* splitmix64 finalizer */
+static uint64_t hash_mix(uint64_t hash)
+{
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBULL;
+    hash ^= hash >> 31;
+
+    return hash;
+}
+
+/* FNV-1a, case sensitive unlike hash_key */
+static uint64_t hash_string(const unsigned char *string)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+
+    for (; *string != '\0'; string++)
+    {
+        hash = (hash ^ *string) * 0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+static uint64_t hash_item(const cJSON * const item)
+{
+    uint64_t hash = (uint64_t)(item->type & 0xFF);
+    const cJSON *child = NULL;
+
+    switch (item->type & 0xFF)
+    {
+        case cJSON_Number:
+        {
+            /* 0.0 and -0.0 compare equal */
+            double number = (item->valuedouble == 0) ? 0 : item->valuedouble;
+            uint64_t bits = 0;
+            memcpy(&bits, &number, sizeof(bits));
+            return hash_mix(hash ^ bits);
+        }
+
+        case cJSON_String:
+        case cJSON_Raw:
+            return hash_mix(hash ^ ((item->valuestring != NULL) ? hash_string((const unsigned char*)item->valuestring) : 0));
+
+        case cJSON_Array:
+            for (child = item->child; child != NULL; child = child->next)
+            {
+                hash = hash_mix(hash + hash_item(child));
+            }
+            return hash_mix(hash);
+
+        case cJSON_Object:
+        {
+            /* a sum, so the order of the members doesn't matter */
+            uint64_t members = 0;
+            for (child = item->child; child != NULL; child = child->next)
+            {
+                uint64_t key = (child->string != NULL) ? hash_string((const unsigned char*)child->string) : 0;
+                members += hash_mix(key ^ (hash_item(child) * 0x9E3779B97F4A7C15ULL));
+            }
+            return hash_mix(hash ^ members);
+        }
+
+        default:
+            return hash_mix(hash);
+    }
+}
+
+CJSON_PUBLIC(size_t) cJSON_Hash(const cJSON * const item)
+{
+    if (item == NULL)
+    {
+        return 0;
+    }
+
+    return (size_t)hash_item(item);
+}
+
 CJSON_PUBLIC(void *) cJSON_malloc(size_t size)
 {
     return global_hooks.allocate(size);
@@ -48,11 +48,17 @@ extern "C"
 
 #define cJSON_IsReference 256
 #define cJSON_StringIsConst 512
+#define cJSON_InArena 1024 /* the item and its strings belong to a cJSON_Arena */
+#define cJSON_InSitu 2048 /* valuestring and string point into the buffer passed to cJSON_ParseInSitu */
+#define cJSON_KeyIsShared 4096 /* string is reference counted and shared with other items, see cJSON_ParseInternKeys */
+#define cJSON_ChildIsShared 8192 /* the children are reference counted and shared with other items, see cJSON_Fork */
+#define cJSON_IsSharedChild 16384 /* the item is one of those shared children and read only */
 
 /* The cJSON structure: */
 typedef struct cJSON
 {
-    /* next/prev allow you to walk array/object chains. Alternatively, use GetArraySize/GetArrayItem/GetObjectItem */
+    /* next/prev allow you to walk array/object chains. Alternatively, use GetArraySize/GetArrayItem/GetObjectItem
+     * The prev pointer of the first item points to the last one, so check for the first item with parent->child. */
     struct cJSON *next;
     struct cJSON *prev;
     /* An array or object item will have a child pointer pointing to a chain of the items in the array/object. */
@@ -61,7 +67,8 @@ typedef struct cJSON
     /* The type of the item, as above. */
     int type;
 
-    /* The item's string, if type==cJSON_String  and type == cJSON_Raw */
+    /* The item's string, if type==cJSON_String  and type == cJSON_Raw
+     * (arrays and objects with cJSON_ChildIsShared keep their bookkeeping here, see cJSON_Fork) */
     char *valuestring;
     /* writing to valueint is DEPRECATED, use cJSON_SetNumberValue instead */
     int valueint;
@@ -70,6 +77,11 @@ typedef struct cJSON
 
     /* The item's name string, if this item is the child of, or is in the list of subitems of an object. */
     char *string;
+
+    /* Lookup index of an array or object, see cJSON_BuildIndex. Maintained by cJSON, don't touch. */
+    struct cJSON_Index *index;
+    /* Hash table over the keys of an object, see cJSON_GetObjectItem. Maintained by cJSON, don't touch. */
+    struct cJSON_KeyTable *keys;
 } cJSON;
 
 typedef struct cJSON_Hooks
@@ -80,6 +92,9 @@ typedef struct cJSON_Hooks
 
 typedef int cJSON_bool;
 
+/* A region allocator for whole documents, see cJSON_CreateArena. */
+typedef struct cJSON_Arena cJSON_Arena;
+
 #if !defined(__WINDOWS__) && (defined(WIN32) || defined(WIN64) || defined(_MSC_VER) || defined(_WIN32))
 #define __WINDOWS__
 #endif
@@ -129,6 +144,17 @@ then using the CJSON_API_VISIBILITY flag to "export" the same symbols the way CJ
 #define CJSON_NESTING_LIMIT 1000
 #endif
 
+/* Objects with more keys than this get a hash table the first time a lookup has to walk past
+ * that many of them. Looking up keys of big objects is O(1) from then on. */
+#ifndef CJSON_HASH_THRESHOLD
+#define CJSON_HASH_THRESHOLD 32
+#endif
+
+/* Size of the buffer that cJSON_PrintToSink prints into before handing the output over. */
+#ifndef CJSON_SINK_BUFFER_SIZE
+#define CJSON_SINK_BUFFER_SIZE 1024
+#endif
+
 /* returns the version of cJSON as a string */
 CJSON_PUBLIC(const char*) cJSON_Version(void);
 
@@ -142,10 +168,20 @@ CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value);
 CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item);
 /* Render a cJSON entity to text for transfer/storage without any formatting. */
 CJSON_PUBLIC(char *) cJSON_PrintUnformatted(const cJSON *item);
+/* Length of the text cJSON_Print (fmt=1) or cJSON_PrintUnformatted (fmt=0) would return, without the '\0'.
+ * Costs about as much as printing, useful for Content-Length before cJSON_PrintToSink or to size the
+ * buffer for cJSON_PrintPreallocated. Returns 0 if item can't be printed. */
+CJSON_PUBLIC(size_t) cJSON_PrintedLength(const cJSON *item, cJSON_bool fmt);
+/* Render a cJSON entity to text piece by piece, without building the whole text in memory.
+ * write_cb gets the output in order, in chunks of up to CJSON_SINK_BUFFER_SIZE bytes (more only for a single
+ * string that is longer than that), without a terminating '\0'. It returns false to stop printing.
+ * Returns true if everything was handed to write_cb. fmt=0 gives unformatted, =1 gives formatted */
+typedef cJSON_bool (*cJSON_PrintSink)(void *context, const char *data, size_t length);
+CJSON_PUBLIC(cJSON_bool) cJSON_PrintToSink(const cJSON *item, cJSON_PrintSink write_cb, void *context, cJSON_bool fmt);
 /* Render a cJSON entity to text using a buffered strategy. prebuffer is a guess at the final size. guessing well reduces reallocation. fmt=0 gives unformatted, =1 gives formatted */
 CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON_bool fmt);
 /* Render a cJSON entity to text using a buffer already allocated in memory with given length. Returns 1 on success and 0 on failure. */
-/* NOTE: cJSON is not always 100% accurate in estimating how much memory it will use, so to be safe allocate 5 bytes more than you actually need */
+/* length has to be at least the length of the output plus one for the terminating '\0'. */
 CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const cJSON_bool format);
 /* Delete a cJSON entity and all subentities. */
 CJSON_PUBLIC(void) cJSON_Delete(cJSON *c);
@@ -154,10 +190,19 @@ CJSON_PUBLIC(void) cJSON_Delete(cJSON *c);
 CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array);
 /* Retrieve item number "item" from array "array". Returns NULL if unsuccessful. */
 CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index);
-/* Get item "string" from object. Case insensitive. */
+/* Get item "string" from object. Case insensitive.
+ * Big objects are searched with a hash table, see CJSON_HASH_THRESHOLD. The table follows items added, inserted,
+ * detached or replaced with the functions below. Don't change the key of a child or modify the child list by hand
+ * while its object has a table, and don't look up keys of the same object from several threads before the first
+ * lookup has built it unless your compiler supports __atomic builtins. */
 CJSON_PUBLIC(cJSON *) cJSON_GetObjectItem(const cJSON * const object, const char * const string);
 CJSON_PUBLIC(cJSON *) cJSON_GetObjectItemCaseSensitive(const cJSON * const object, const char * const string);
 CJSON_PUBLIC(cJSON_bool) cJSON_HasObjectItem(const cJSON *object, const char *string);
+/* Build a lookup index for an array or object (and its children with recurse), so cJSON_GetArrayItem and
+ * cJSON_GetArraySize are O(1). Objects also get the hash table used by cJSON_GetObjectItem right away. The index follows items added with cJSON_AddItemTo..., any other change
+ * of the children drops it. Don't modify the child list by hand while an item has an index.
+ * Arena items can only be indexed while parsing. Returns 0 on allocation failure. */
+CJSON_PUBLIC(cJSON_bool) cJSON_BuildIndex(cJSON *item, cJSON_bool recurse);
 /* For analysing failed parses. This returns a pointer to the parse error. You'll probably need to look a few chars back to make sense of it. Defined when cJSON_Parse() returns 0. 0 when cJSON_Parse() succeeds. */
 CJSON_PUBLIC(const char *) cJSON_GetErrorPtr(void);
 
@@ -220,20 +265,206 @@ CJSON_PUBLIC(void) cJSON_ReplaceItemInObjectCaseSensitive(cJSON *object,const ch
 
 /* Duplicate a cJSON item */
 CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse);
+
 /* Duplicate will create a new, identical cJSON item to the one you pass, in new memory that will
 need to be released. With recurse!=0, it will duplicate any children connected to the item.
 The item->next and ->prev pointers are always zero on return from Duplicate. */
+
+/* Copy-on-write documents: cJSON_Fork returns a copy of item that shares all arrays and objects below item with it
+ * instead of duplicating them, so forking a template and changing a few members of the fork costs time and memory
+ * for the path to those members only. The functions that add, insert, detach, replace or delete children call
+ * cJSON_Unshare on the parent first, which gives it its own copy of its direct children. Items still inside shared
+ * children are read only, those functions, cJSON_SetNumberValue and cJSON_Delete ignore them, so unshare the path
+ * down to the item being changed first, e.g.
+ *     cJSON *device = cJSON_Fork(template);
+ *     cJSON_Unshare(device);
+ *     wifi = cJSON_GetObjectItem(device, "wifi");
+ *     cJSON_ReplaceItemInObject(wifi, "ssid", cJSON_CreateString(ssid));
+ * Delete forks and the original with cJSON_Delete in any order. Forking leaves every child where it is, so
+ * pointers into item stay valid. Changing children that are still shared with another item gives the changed
+ * parent copies of them, so pointers to its children taken before then point to the ones the others keep.
+ * The first fork of a document changes how it is stored, so fork it before handing it to other threads; after
+ * that forks can be used and deleted concurrently.
+ * Returns NULL on allocation failure and for items that belong to an arena or contain references. */
+CJSON_PUBLIC(cJSON *) cJSON_Fork(cJSON *item);
+/* Give item its own copy of its direct children if they are shared (see cJSON_Fork), children that are arrays or
+ * objects go on sharing theirs. If nobody else shares them any more, item takes them over as they are instead.
+ * Returns 0 on allocation failure and if item is itself a shared child, leaving item unchanged. */
+CJSON_PUBLIC(cJSON_bool) cJSON_Unshare(cJSON *item);
 /* Recursively compare two cJSON items for equality. If either a or b is NULL or invalid, they will be considered unequal.
  * case_sensitive determines if object keys are treated case sensitive (1) or case insensitive (0) */
 CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * const b, const cJSON_bool case_sensitive);
+/* Hash of the contents of item, to tell cheaply whether a document changed since a hash was taken. Items that are
+ * equal according to cJSON_Compare(a, b, 1) have the same hash, the order of object members doesn't matter. */
+CJSON_PUBLIC(size_t) cJSON_Hash(const cJSON * const item);
 
 
 /* ParseWithOpts allows you to require (and check) that the JSON is null terminated, and to retrieve the pointer to the final byte parsed. */
 /* If you supply a ptr in return_parse_end and parsing fails, then return_parse_end will contain a pointer to the error. If not, then cJSON_GetErrorPtr() does the job. */
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
+/* Flags for cJSON_ParseWithFlags */
+#define cJSON_ParseBuildIndex (1 << 0) /* build the lookup index of every array and object, see cJSON_BuildIndex */
+#define cJSON_ParseHashKeys (1 << 1) /* build the hash table of every object, regardless of CJSON_HASH_THRESHOLD */
+/* Store every distinct key only once and let all members with that key share it. Saves memory and time for arrays of
+ * objects that look alike. The keys of such a document can be compared by pointer, and are freed with the last item
+ * that uses them. Has no effect on cJSON_ParseInSitu, which doesn't copy keys at all. */
+#define cJSON_ParseInternKeys (1 << 2)
+/* ParseWithOpts with a combination of the flags above */
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithFlags(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated, int flags);
+
+/* Parse without copying strings: keys and string values are unescaped inside of value, and
+ * valuestring/string point there. value has to outlive the returned tree (and anything that was
+ * detached from it), and its contents are undefined afterwards, even if parsing fails.
+ * The tree is still freed with cJSON_Delete. cJSON_Duplicate makes a copy that owns its strings. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSitu(char *value);
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSituWithOpts(char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
+
+/* Streaming parser: feed a document in chunks of any size (e.g. as they are read from a socket)
+ * and get an event for every value instead of a tree. Memory use is bounded by the longest string
+ * or number in the document, not by the size of the document. */
+typedef enum
+{
+    cJSON_StreamValue, /* a string, number, boolean or null */
+    cJSON_StreamBegin, /* start of an array or object, its children follow */
+    cJSON_StreamEnd /* end of an array or object */
+} cJSON_StreamEvent;
+/* item is only valid during the call. Its type says what was read, valuestring/valuedouble/valueint
+ * hold the value and string holds the key if the value is a member of an object.
+ * depth is the number of arrays/objects around the value, Begin and End of the same array/object
+ * report the same depth. Return false to stop parsing, cJSON_StreamFeed fails then. */
+typedef cJSON_bool (*cJSON_StreamHandler)(void *context, cJSON_StreamEvent event, const cJSON *item, int depth);
+typedef struct cJSON_Stream cJSON_Stream;
+CJSON_PUBLIC(cJSON_Stream *) cJSON_CreateStream(cJSON_StreamHandler handler, void *context);
+/* Returns false on invalid JSON, on allocation failure or if the handler stopped parsing.
+ * The stream stays failed, cJSON_StreamOffset tells where that happened. */
+CJSON_PUBLIC(cJSON_bool) cJSON_StreamFeed(cJSON_Stream *stream, const char *chunk, size_t length);
+/* Call at the end of the input. Returns true if exactly one complete document was read. */
+CJSON_PUBLIC(cJSON_bool) cJSON_StreamFinish(cJSON_Stream *stream);
+/* Number of bytes consumed so far */
+CJSON_PUBLIC(size_t) cJSON_StreamOffset(const cJSON_Stream *stream);
+CJSON_PUBLIC(void) cJSON_DeleteStream(cJSON_Stream *stream);
+
+/* Contexts: the configuration and error state of the functions above, without globals.
+ * cJSON_Parse and friends report errors through cJSON_GetErrorPtr and allocate with the hooks of
+ * cJSON_InitHooks, which is shared by all threads. The ...WithContext variants take both from the
+ * context instead, so threads that each use their own context can parse and print concurrently.
+ * A context must only be used by one thread at a time.
+ * hooks are copied, NULL means malloc/free. The nesting limit starts at CJSON_NESTING_LIMIT and
+ * the parse flags (see cJSON_ParseWithFlags) at 0. */
+typedef struct cJSON_Context cJSON_Context;
+CJSON_PUBLIC(cJSON_Context *) cJSON_CreateContext(const cJSON_Hooks *hooks);
+CJSON_PUBLIC(void) cJSON_DeleteContext(cJSON_Context *context);
+CJSON_PUBLIC(void) cJSON_SetNestingLimit(cJSON_Context *context, size_t limit);
+CJSON_PUBLIC(void) cJSON_SetParseFlags(cJSON_Context *context, int flags);
+/* Like cJSON_GetErrorPtr, for the last parse with this context. Unlike cJSON_GetErrorPtr it is also
+ * set when return_parse_end was given. NULL if that parse succeeded. */
+CJSON_PUBLIC(const char *) cJSON_GetContextError(const cJSON_Context *context);
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithContext(cJSON_Context *context, const char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSituWithContext(cJSON_Context *context, char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
+CJSON_PUBLIC(cJSON *) cJSON_ParseInArenaWithContext(cJSON_Context *context, cJSON_Arena *arena, const char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
+/* A stream that allocates with the context's hooks and stops at its nesting limit. The parse flags
+ * only concern trees and don't apply, errors are reported by cJSON_StreamOffset as usual.
+ * The hooks are copied, the context doesn't have to outlive the stream. */
+CJSON_PUBLIC(cJSON_Stream *) cJSON_CreateStreamWithContext(cJSON_Context *context, cJSON_StreamHandler handler, void *handler_context);
+/* Text printed with a context is freed with the free_fn of its hooks. */
+CJSON_PUBLIC(char *) cJSON_PrintWithContext(cJSON_Context *context, const cJSON *item);
+CJSON_PUBLIC(char *) cJSON_PrintUnformattedWithContext(cJSON_Context *context, const cJSON *item);
+CJSON_PUBLIC(char *) cJSON_PrintBufferedWithContext(cJSON_Context *context, const cJSON *item, int prebuffer, cJSON_bool fmt);
+CJSON_PUBLIC(cJSON_bool) cJSON_PrintToSinkWithContext(cJSON_Context *context, const cJSON *item, cJSON_PrintSink write_cb, void *sink_context, cJSON_bool fmt);
+/* Trees parsed with a context that has its own hooks have to be deleted with this. The other functions
+ * (cJSON_AddItemTo..., cJSON_Duplicate etc.) still use the global hooks, so don't mix the two in one tree
+ * unless both hooks are the same. cJSON_PrintPreallocated doesn't allocate and needs no context. */
+CJSON_PUBLIC(void) cJSON_DeleteWithContext(cJSON_Context *context, cJSON *item);
+
+/* Batches: parse newline delimited JSON (one document per line) on several threads at once.
+ * length bytes of json are copied, blank lines are skipped and every other line is parsed as
+ * a document of its own, with the given cJSON_Parse... flags. threads is the most workers to
+ * use, <= 0 means one per CPU. Small inputs use fewer workers.
+ * The roots are returned in input order, cJSON_GetBatchItem gives NULL for lines that aren't
+ * valid JSON. They live in arenas (see below) and strings point into the copy of the input,
+ * so they are only valid until cJSON_DeleteBatch, which frees everything.
+ * Returns NULL if memory runs out. */
+typedef struct cJSON_Batch cJSON_Batch;
+CJSON_PUBLIC(cJSON_Batch *) cJSON_ParseBatch(const char *json, size_t length, int flags, int threads);
+CJSON_PUBLIC(size_t) cJSON_GetBatchSize(const cJSON_Batch *batch);
+CJSON_PUBLIC(cJSON *) cJSON_GetBatchItem(const cJSON_Batch *batch, size_t index);
+CJSON_PUBLIC(void) cJSON_DeleteBatch(cJSON_Batch *batch);
+
+/* Check that the length bytes at json are exactly one well-formed JSON text (RFC 8259), without
+ * building a tree or allocating anything. Stricter than cJSON_Parse: strings have to be valid UTF-8
+ * with paired surrogate escapes, numbers have to follow the JSON grammar, only ' ', '\t', '\n' and
+ * '\r' count as whitespace, and a '\0' is an error. Nesting is limited to CJSON_NESTING_LIMIT.
+ * If the text isn't valid and error_offset isn't NULL, it gets the offset of the first wrong byte
+ * (length if the text ends too early). */
+CJSON_PUBLIC(cJSON_bool) cJSON_Validate(const char *json, size_t length, size_t *error_offset);
+
+/* Tapes: a read-only document stored in one array of items in document order, instead of a tree of
+ * separately allocated cJSON items, which makes large documents cheaper to parse, walk and free.
+ * An array or object is followed by its children, and skip is the number of items it takes up
+ * together with them (1 for everything else), so item + item->skip is the item after it.
+ * Strings point into a copy of the input owned by the tape; everything stays valid until
+ * cJSON_DeleteTape. Errors are reported like for cJSON_ParseWithOpts. */
+typedef struct cJSON_Tape cJSON_Tape;
+typedef struct cJSON_TapeItem
+{
+    /* The item's name string, if it is a member of an object. */
+    const char *string;
+    /* The item's string, if type==cJSON_String */
+    const char *valuestring;
+    /* The item's number, if type==cJSON_Number */
+    double valuedouble;
+    /* The type of the item, as for cJSON items. */
+    int type;
+    unsigned int skip;
+} cJSON_TapeItem;
+
+CJSON_PUBLIC(cJSON_Tape *) cJSON_ParseTape(const char *value);
+CJSON_PUBLIC(cJSON_Tape *) cJSON_ParseTapeWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
+/* Like cJSON_ParseWithContext: allocates with the context's hooks, stops at its nesting limit and reports
+ * errors through cJSON_GetContextError. The tape keeps a copy of the hooks, cJSON_DeleteTape frees it with them. */
+CJSON_PUBLIC(cJSON_Tape *) cJSON_ParseTapeWithContext(cJSON_Context *context, const char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
+CJSON_PUBLIC(void) cJSON_DeleteTape(cJSON_Tape *tape);
+CJSON_PUBLIC(const cJSON_TapeItem *) cJSON_GetTapeRoot(const cJSON_Tape *tape);
+/* The same as their counterparts for cJSON items. */
+CJSON_PUBLIC(int) cJSON_GetTapeArraySize(const cJSON_TapeItem *array);
+CJSON_PUBLIC(const cJSON_TapeItem *) cJSON_GetTapeArrayItem(const cJSON_TapeItem *array, int index);
+CJSON_PUBLIC(const cJSON_TapeItem *) cJSON_GetTapeObjectItem(const cJSON_TapeItem *object, const char *string);
+CJSON_PUBLIC(const cJSON_TapeItem *) cJSON_GetTapeObjectItemCaseSensitive(const cJSON_TapeItem *object, const char *string);
+/* Iterate over the children of a tape array or object, like cJSON_ArrayForEach. */
+#define cJSON_TapeArrayForEach(element, array) for(element = ((array) != NULL) ? (array) + 1 : NULL; (element != NULL) && (element < (array) + (array)->skip); element += element->skip)
 
 CJSON_PUBLIC(void) cJSON_Minify(char *json);
 
+/* Arenas: parse or build a document with a bump allocator and free all of it at once.
+ * Items, keys and strings are taken from big blocks, so a document costs a handful of
+ * allocations instead of several per item, and cJSON_ResetArena/cJSON_DeleteArena release
+ * it in one go. cJSON_Delete does nothing for arena items.
+ * An arena is not thread safe, but different threads can use different arenas at the same
+ * time. The blocks come from the hooks that were set when the arena was created.
+ * Only link arena items with items from the same arena: heap items added to an arena document
+ * are not freed with it, and cJSON_AddItemToObject would give an arena item a heap key, so
+ * use cJSON_ArenaAddItemToObject instead. cJSON_Duplicate of an arena item returns a heap copy. */
+/* block_size is the size of the blocks the arena allocates, 0 selects a default. */
+CJSON_PUBLIC(cJSON_Arena *) cJSON_CreateArena(size_t block_size);
+/* Free everything allocated from the arena, but keep one block for reuse. */
+CJSON_PUBLIC(void) cJSON_ResetArena(cJSON_Arena *arena);
+CJSON_PUBLIC(void) cJSON_DeleteArena(cJSON_Arena *arena);
+/* Allocate memory that lives as long as the arena. */
+CJSON_PUBLIC(void *) cJSON_ArenaMalloc(cJSON_Arena *arena, size_t size);
+CJSON_PUBLIC(cJSON *) cJSON_ParseInArena(cJSON_Arena *arena, const char *value);
+CJSON_PUBLIC(cJSON *) cJSON_ParseInArenaWithOpts(cJSON_Arena *arena, const char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
+CJSON_PUBLIC(cJSON *) cJSON_ArenaCreateNull(cJSON_Arena *arena);
+CJSON_PUBLIC(cJSON *) cJSON_ArenaCreateTrue(cJSON_Arena *arena);
+CJSON_PUBLIC(cJSON *) cJSON_ArenaCreateFalse(cJSON_Arena *arena);
+CJSON_PUBLIC(cJSON *) cJSON_ArenaCreateBool(cJSON_Arena *arena, cJSON_bool boolean);
+CJSON_PUBLIC(cJSON *) cJSON_ArenaCreateNumber(cJSON_Arena *arena, double num);
+CJSON_PUBLIC(cJSON *) cJSON_ArenaCreateString(cJSON_Arena *arena, const char *string);
+CJSON_PUBLIC(cJSON *) cJSON_ArenaCreateRaw(cJSON_Arena *arena, const char *raw);
+CJSON_PUBLIC(cJSON *) cJSON_ArenaCreateArray(cJSON_Arena *arena);
+CJSON_PUBLIC(cJSON *) cJSON_ArenaCreateObject(cJSON_Arena *arena);
+/* Like cJSON_AddItemToObject, but the copy of the key is allocated from the arena. */
+CJSON_PUBLIC(void) cJSON_ArenaAddItemToObject(cJSON_Arena *arena, cJSON *object, const char *string, cJSON *item);
+
 /* Macros for creating things quickly. */
 #define cJSON_AddNullToObject(object,name) cJSON_AddItemToObject(object, name, cJSON_CreateNull())
 #define cJSON_AddTrueToObject(object,name) cJSON_AddItemToObject(object, name, cJSON_CreateTrue())
@@ -242,6 +473,13 @@ CJSON_PUBLIC(void) cJSON_Minify(char *json);
 #define cJSON_AddNumberToObject(object,name,n) cJSON_AddItemToObject(object, name, cJSON_CreateNumber(n))
 #define cJSON_AddStringToObject(object,name,s) cJSON_AddItemToObject(object, name, cJSON_CreateString(s))
 #define cJSON_AddRawToObject(object,name,s) cJSON_AddItemToObject(object, name, cJSON_CreateRaw(s))
+#define cJSON_ArenaAddNullToObject(arena,object,name) cJSON_ArenaAddItemToObject(arena, object, name, cJSON_ArenaCreateNull(arena))
+#define cJSON_ArenaAddTrueToObject(arena,object,name) cJSON_ArenaAddItemToObject(arena, object, name, cJSON_ArenaCreateTrue(arena))
+#define cJSON_ArenaAddFalseToObject(arena,object,name) cJSON_ArenaAddItemToObject(arena, object, name, cJSON_ArenaCreateFalse(arena))
+#define cJSON_ArenaAddBoolToObject(arena,object,name,b) cJSON_ArenaAddItemToObject(arena, object, name, cJSON_ArenaCreateBool(arena, b))
+#define cJSON_ArenaAddNumberToObject(arena,object,name,n) cJSON_ArenaAddItemToObject(arena, object, name, cJSON_ArenaCreateNumber(arena, n))
+#define cJSON_ArenaAddStringToObject(arena,object,name,s) cJSON_ArenaAddItemToObject(arena, object, name, cJSON_ArenaCreateString(arena, s))
+#define cJSON_ArenaAddRawToObject(arena,object,name,s) cJSON_ArenaAddItemToObject(arena, object, name, cJSON_ArenaCreateRaw(arena, s))
 
 /* When assigning an integer value, it needs to be propagated to valuedouble too. */
 #define cJSON_SetIntValue(object, number) ((object) ? (object)->valueint = (object)->valuedouble = (number) : (number))
@@ -0,0 +1,1211 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifdef __GNUC__
+#pragma GCC visibility push(default)
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <stdint.h>
+#include <float.h>
+
+#ifdef __GNUC__
+#pragma GCC visibility pop
+#endif
+
+#include "cJSON_Utils.h"
+
+/* define our own boolean type */
+#define true ((cJSON_bool)1)
+#define false ((cJSON_bool)0)
+
+#define NO_INDEX ((size_t)-1)
+
+/* One reference token of the compiled pointers. The tokens that follow it in any of the
+ * pointers are its children, so pointers with a common prefix share the nodes of that prefix. */
+typedef struct path_node
+{
+    struct path_node *child; /* first token that can follow this one */
+    struct path_node *next; /* next token that can follow the parent */
+    size_t children;
+    char *key; /* the unescaped token, NULL for the root */
+    size_t index; /* the token as an array index, NO_INDEX if it isn't one */
+    size_t result; /* the first pointer that ends with this token, NO_INDEX if none does */
+} path_node;
+
+struct cJSONUtils_Paths
+{
+    path_node root;
+    size_t count;
+    size_t *same_as; /* for every pointer, the first one that is equal to it */
+};
+
+static void delete_nodes(path_node *node)
+{
+    while (node != NULL)
+    {
+        path_node *next = node->next;
+
+        delete_nodes(node->child);
+        cJSON_free(node->key);
+        cJSON_free(node);
+        node = next;
+    }
+}
+
+/* Unescape the token at *pointer (after the '/'), and move *pointer to its end.
+ * Returns NULL for invalid escape sequences. */
+static char *decode_token(const char **pointer)
+{
+    const char *end = *pointer;
+    char *token = NULL;
+    char *output = NULL;
+
+    while ((*end != '\0') && (*end != '/'))
+    {
+        end++;
+    }
+
+    output = token = (char*)cJSON_malloc((size_t)(end - *pointer) + 1);
+    if (token == NULL)
+    {
+        return NULL;
+    }
+
+    for (; *pointer < end; (*pointer)++)
+    {
+        if (**pointer != '~')
+        {
+            *output++ = **pointer;
+            continue;
+        }
+
+        /* "~0" is '~' and "~1" is '/' */
+        (*pointer)++;
+        if ((*pointer < end) && ((**pointer == '0') || (**pointer == '1')))
+        {
+            *output++ = (**pointer == '0') ? '~' : '/';
+        }
+        else
+        {
+            cJSON_free(token);
+            return NULL;
+        }
+    }
+    *output = '\0';
+
+    return token;
+}
+
+/* Array index of a token: digits without leading zeroes. */
+static size_t token_index(const char *token)
+{
+    size_t index = 0;
+
+    if ((token[0] == '\0') || ((token[0] == '0') && (token[1] != '\0')))
+    {
+        return NO_INDEX;
+    }
+
+    for (; *token != '\0'; token++)
+    {
+        if ((*token < '0') || (*token > '9') || (index > ((size_t)INT_MAX - 9) / 10))
+        {
+            return NO_INDEX; /* cJSON_GetArrayItem takes an int */
+        }
+        index = (index * 10) + (size_t)(*token - '0');
+    }
+
+    return index;
+}
+
+/* Find the child of node with the given token, or add it. Takes ownership of key. */
+static path_node *add_token(path_node * const node, char *key)
+{
+    path_node *child = NULL;
+    path_node **last = &node->child;
+
+    for (child = node->child; child != NULL; child = child->next)
+    {
+        if (strcmp(child->key, key) == 0)
+        {
+            cJSON_free(key);
+            return child;
+        }
+        last = &child->next;
+    }
+
+    child = (path_node*)cJSON_malloc(sizeof(path_node));
+    if (child == NULL)
+    {
+        cJSON_free(key);
+        return NULL;
+    }
+    memset(child, '\0', sizeof(path_node));
+    child->key = key;
+    child->index = token_index(key);
+    child->result = NO_INDEX;
+
+    /* keep the order of the pointers */
+    *last = child;
+    node->children++;
+
+    return child;
+}
+
+CJSON_PUBLIC(cJSONUtils_Paths *) cJSONUtils_CompilePaths(const char * const *pointers, size_t count)
+{
+    cJSONUtils_Paths *paths = NULL;
+    size_t i = 0;
+
+    if ((pointers == NULL) && (count > 0))
+    {
+        return NULL;
+    }
+
+    paths = (cJSONUtils_Paths*)cJSON_malloc(sizeof(cJSONUtils_Paths));
+    if (paths == NULL)
+    {
+        return NULL;
+    }
+    memset(paths, '\0', sizeof(cJSONUtils_Paths));
+    paths->root.index = NO_INDEX;
+    paths->root.result = NO_INDEX;
+    paths->count = count;
+
+    paths->same_as = (size_t*)cJSON_malloc((count > 0 ? count : 1) * sizeof(size_t));
+    if (paths->same_as == NULL)
+    {
+        goto fail;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        const char *pointer = pointers[i];
+        path_node *node = &paths->root;
+
+        if (pointer == NULL)
+        {
+            goto fail;
+        }
+
+        while (*pointer != '\0')
+        {
+            char *key = NULL;
+
+            if (*pointer != '/')
+            {
+                goto fail; /* every token starts with a '/' */
+            }
+            pointer++;
+
+            key = decode_token(&pointer);
+            if (key == NULL)
+            {
+                goto fail;
+            }
+            node = add_token(node, key);
+            if (node == NULL)
+            {
+                goto fail;
+            }
+        }
+
+        if (node->result == NO_INDEX)
+        {
+            node->result = i;
+        }
+        paths->same_as[i] = node->result;
+    }
+
+    return paths;
+
+fail:
+    cJSONUtils_DeletePaths(paths);
+
+    return NULL;
+}
+
+CJSON_PUBLIC(void) cJSONUtils_DeletePaths(cJSONUtils_Paths *paths)
+{
+    if (paths == NULL)
+    {
+        return;
+    }
+
+    delete_nodes(paths->root.child);
+    if (paths->same_as != NULL)
+    {
+        cJSON_free(paths->same_as);
+    }
+    cJSON_free(paths);
+}
+
+static void evaluate_node(const path_node * const node, cJSON * const item, cJSON ** const results);
+
+static void evaluate_object(const path_node * const node, cJSON * const object, cJSON ** const results)
+{
+    const path_node *first = NULL;
+    const path_node *after = NULL;
+
+    if ((node->children == 1) || (object->keys != NULL))
+    {
+        /* a single key, or an object with a hash table: look the keys up one by one */
+        const path_node *token = NULL;
+
+        for (token = node->child; token != NULL; token = token->next)
+        {
+            cJSON *member = cJSON_GetObjectItemCaseSensitive(object, token->key);
+            if (member != NULL)
+            {
+                evaluate_node(token, member, results);
+            }
+        }
+        return;
+    }
+
+    /* otherwise match every member against all keys (up to 64 at a time), walking the members once */
+    for (first = node->child; first != NULL; first = after)
+    {
+        uint64_t pending = 0;
+        const path_node *token = NULL;
+        cJSON *member = NULL;
+        size_t bit = 0;
+
+        for (after = first, bit = 0; (after != NULL) && (bit < 64); after = after->next, bit++)
+        {
+            pending |= (uint64_t)1 << bit;
+        }
+
+        for (member = object->child; (member != NULL) && (pending != 0); member = member->next)
+        {
+            if (member->string == NULL)
+            {
+                continue;
+            }
+
+            for (token = first, bit = 0; token != after; token = token->next, bit++)
+            {
+                /* like cJSON_GetObjectItem, the first member with the key wins */
+                if ((pending & ((uint64_t)1 << bit)) && (token->key[0] == member->string[0]) && (strcmp(token->key, member->string) == 0))
+                {
+                    pending &= ~((uint64_t)1 << bit);
+                    evaluate_node(token, member, results);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+static void evaluate_array(const path_node * const node, cJSON * const array, cJSON ** const results)
+{
+    const path_node *token = NULL;
+    cJSON *element = NULL;
+    size_t position = 0;
+    size_t last = 0;
+    cJSON_bool has_index = false;
+
+    if (node->children == 1)
+    {
+        /* cJSON_GetArrayItem is O(1) if the array has an index */
+        if (node->child->index != NO_INDEX)
+        {
+            element = cJSON_GetArrayItem(array, (int)node->child->index);
+            if (element != NULL)
+            {
+                evaluate_node(node->child, element, results);
+            }
+        }
+        return;
+    }
+
+    for (token = node->child; token != NULL; token = token->next)
+    {
+        if ((token->index != NO_INDEX) && (!has_index || (token->index > last)))
+        {
+            last = token->index;
+            has_index = true;
+        }
+    }
+    if (!has_index)
+    {
+        return;
+    }
+
+    /* walk the elements once, up to the highest index */
+    for (element = array->child; (element != NULL) && (position <= last); element = element->next, position++)
+    {
+        for (token = node->child; token != NULL; token = token->next)
+        {
+            if (token->index == position)
+            {
+                evaluate_node(token, element, results);
+                break;
+            }
+        }
+    }
+}
+
+static void evaluate_node(const path_node * const node, cJSON * const item, cJSON ** const results)
+{
+    if (node->result != NO_INDEX)
+    {
+        results[node->result] = item;
+    }
+
+    if (node->child == NULL)
+    {
+        return;
+    }
+
+    if (cJSON_IsObject(item))
+    {
+        evaluate_object(node, item, results);
+    }
+    else if (cJSON_IsArray(item))
+    {
+        evaluate_array(node, item, results);
+    }
+}
+
+CJSON_PUBLIC(size_t) cJSONUtils_EvaluatePaths(const cJSONUtils_Paths *paths, cJSON * const object, cJSON **results)
+{
+    size_t found = 0;
+    size_t i = 0;
+
+    if ((paths == NULL) || ((results == NULL) && (paths->count > 0)))
+    {
+        return 0;
+    }
+
+    for (i = 0; i < paths->count; i++)
+    {
+        results[i] = NULL;
+    }
+
+    if (object == NULL)
+    {
+        return 0;
+    }
+
+    evaluate_node(&paths->root, object, results);
+
+    for (i = 0; i < paths->count; i++)
+    {
+        /* equal pointers share a node, which only knows the first of them */
+        results[i] = results[paths->same_as[i]];
+        if (results[i] != NULL)
+        {
+            found++;
+        }
+    }
+
+    return found;
+}
+
+CJSON_PUBLIC(cJSON *) cJSONUtils_GetPointer(cJSON * const object, const char *pointer)
+{
+    cJSONUtils_Paths *paths = NULL;
+    cJSON *result = NULL;
+
+    paths = cJSONUtils_CompilePaths(&pointer, 1);
+    if (paths == NULL)
+    {
+        return NULL;
+    }
+
+    cJSONUtils_EvaluatePaths(paths, object, &result);
+    cJSONUtils_DeletePaths(paths);
+
+    return result;
+}
+
+/* CBOR (RFC 8949). Every data item starts with a byte holding the major type in the top
+ * three bits and either a small argument or the size of the argument that follows. */
+#define CBOR_UNSIGNED 0
+#define CBOR_NEGATIVE 1
+#define CBOR_BYTES 2
+#define CBOR_TEXT 3
+#define CBOR_ARRAY 4
+#define CBOR_MAP 5
+#define CBOR_TAG 6
+#define CBOR_SIMPLE 7
+
+#define CBOR_FALSE 0xF4
+#define CBOR_TRUE 0xF5
+#define CBOR_NULL 0xF6
+#define CBOR_UNDEFINED 0xF7
+#define CBOR_HALF 0xF9
+#define CBOR_FLOAT 0xFA
+#define CBOR_DOUBLE 0xFB
+#define CBOR_BREAK 0xFF
+#define CBOR_INDEFINITE 31
+
+/* bytes needed for the head of a data item with the given argument */
+static size_t cbor_head_size(const uint64_t argument)
+{
+    if (argument < 24)
+    {
+        return 1;
+    }
+    if (argument <= 0xFF)
+    {
+        return 2;
+    }
+    if (argument <= 0xFFFF)
+    {
+        return 3;
+    }
+    if (argument <= 0xFFFFFFFF)
+    {
+        return 5;
+    }
+
+    return 9;
+}
+
+static unsigned char *cbor_write_big_endian(unsigned char *output, const uint64_t value, size_t bytes)
+{
+    while (bytes > 0)
+    {
+        bytes--;
+        *output++ = (unsigned char)(value >> (bytes * 8));
+    }
+
+    return output;
+}
+
+static unsigned char *cbor_write_head(unsigned char *output, const unsigned char major, const uint64_t argument)
+{
+    switch (cbor_head_size(argument))
+    {
+        case 1:
+            *output++ = (unsigned char)((major << 5) | argument);
+            return output;
+        case 2:
+            *output++ = (unsigned char)((major << 5) | 24);
+            return cbor_write_big_endian(output, argument, 1);
+        case 3:
+            *output++ = (unsigned char)((major << 5) | 25);
+            return cbor_write_big_endian(output, argument, 2);
+        case 5:
+            *output++ = (unsigned char)((major << 5) | 26);
+            return cbor_write_big_endian(output, argument, 4);
+        default:
+            *output++ = (unsigned char)((major << 5) | 27);
+            return cbor_write_big_endian(output, argument, 8);
+    }
+}
+
+/* whole numbers go into integers, the rest into the smallest float that holds them exactly */
+typedef enum
+{
+    cbor_positive,
+    cbor_negative,
+    cbor_float,
+    cbor_double,
+    cbor_nan /* NaN and infinity, written as null like cJSON_Print does */
+} cbor_number_kind;
+
+static cbor_number_kind cbor_classify_number(const double number, uint64_t * const argument)
+{
+    if ((number * 0) != 0)
+    {
+        return cbor_nan;
+    }
+
+    if ((number >= 0) && (number < 18446744073709551616.0) && ((double)(uint64_t)number == number)
+            && !((number == 0) && ((1 / number) < 0)))
+    {
+        *argument = (uint64_t)number;
+        return cbor_positive;
+    }
+    if ((number < 0) && (number >= -9223372036854775808.0) && ((double)(int64_t)number == number))
+    {
+        /* the value is -1 - argument */
+        *argument = (uint64_t)(-((int64_t)number + 1));
+        return cbor_negative;
+    }
+    if ((number <= FLT_MAX) && (number >= -FLT_MAX) && ((double)(float)number == number))
+    {
+        return cbor_float;
+    }
+
+    return cbor_double;
+}
+
+/* Size of the encoding of item, 0 if it can't be encoded. */
+static size_t cbor_measure(const cJSON * const item, const size_t depth)
+{
+    const cJSON *child = NULL;
+    uint64_t argument = 0;
+    size_t size = 0;
+    size_t count = 0;
+
+    if (depth >= CJSON_NESTING_LIMIT)
+    {
+        return 0;
+    }
+
+    switch (item->type & 0xFF)
+    {
+        case cJSON_False:
+        case cJSON_True:
+        case cJSON_NULL:
+            return 1;
+
+        case cJSON_Number:
+            switch (cbor_classify_number(item->valuedouble, &argument))
+            {
+                case cbor_positive:
+                case cbor_negative:
+                    return cbor_head_size(argument);
+                case cbor_float:
+                    return 5;
+                case cbor_double:
+                    return 9;
+                default:
+                    return 1;
+            }
+
+        case cJSON_String:
+            if (item->valuestring == NULL)
+            {
+                return 0;
+            }
+            size = strlen(item->valuestring);
+            return cbor_head_size(size) + size;
+
+        case cJSON_Array:
+        case cJSON_Object:
+            for (child = item->child; child != NULL; child = child->next)
+            {
+                size_t child_size = cbor_measure(child, depth + 1);
+                if (child_size == 0)
+                {
+                    return 0;
+                }
+                if ((item->type & 0xFF) == cJSON_Object)
+                {
+                    size_t key_size = 0;
+                    if (child->string == NULL)
+                    {
+                        return 0;
+                    }
+                    key_size = strlen(child->string);
+                    child_size += cbor_head_size(key_size) + key_size;
+                }
+                size += child_size;
+                count++;
+            }
+            return cbor_head_size(count) + size;
+
+        default:
+            /* raw JSON and invalid items */
+            return 0;
+    }
+}
+
+static unsigned char *cbor_write(const cJSON * const item, unsigned char *output)
+{
+    const cJSON *child = NULL;
+    uint64_t argument = 0;
+    size_t length = 0;
+    size_t count = 0;
+
+    switch (item->type & 0xFF)
+    {
+        case cJSON_False:
+            *output++ = CBOR_FALSE;
+            return output;
+
+        case cJSON_True:
+            *output++ = CBOR_TRUE;
+            return output;
+
+        case cJSON_NULL:
+            *output++ = CBOR_NULL;
+            return output;
+
+        case cJSON_Number:
+            switch (cbor_classify_number(item->valuedouble, &argument))
+            {
+                case cbor_positive:
+                    return cbor_write_head(output, CBOR_UNSIGNED, argument);
+                case cbor_negative:
+                    return cbor_write_head(output, CBOR_NEGATIVE, argument);
+                case cbor_float:
+                {
+                    float number = (float)item->valuedouble;
+                    uint32_t bits = 0;
+                    memcpy(&bits, &number, sizeof(bits));
+                    *output++ = CBOR_FLOAT;
+                    return cbor_write_big_endian(output, bits, 4);
+                }
+                case cbor_double:
+                {
+                    uint64_t bits = 0;
+                    memcpy(&bits, &item->valuedouble, sizeof(bits));
+                    *output++ = CBOR_DOUBLE;
+                    return cbor_write_big_endian(output, bits, 8);
+                }
+                default:
+                    *output++ = CBOR_NULL;
+                    return output;
+            }
+
+        case cJSON_String:
+            length = strlen(item->valuestring);
+            output = cbor_write_head(output, CBOR_TEXT, length);
+            memcpy(output, item->valuestring, length);
+            return output + length;
+
+        default:
+            for (child = item->child; child != NULL; child = child->next)
+            {
+                count++;
+            }
+            output = cbor_write_head(output, ((item->type & 0xFF) == cJSON_Object) ? CBOR_MAP : CBOR_ARRAY, count);
+            for (child = item->child; child != NULL; child = child->next)
+            {
+                if ((item->type & 0xFF) == cJSON_Object)
+                {
+                    length = strlen(child->string);
+                    output = cbor_write_head(output, CBOR_TEXT, length);
+                    memcpy(output, child->string, length);
+                    output += length;
+                }
+                output = cbor_write(child, output);
+            }
+            return output;
+    }
+}
+
+CJSON_PUBLIC(unsigned char *) cJSONUtils_EncodeCBOR(const cJSON * const item, size_t *length)
+{
+    unsigned char *output = NULL;
+    size_t size = 0;
+
+    if ((item == NULL) || (length == NULL))
+    {
+        return NULL;
+    }
+
+    size = cbor_measure(item, 0);
+    if (size == 0)
+    {
+        return NULL;
+    }
+
+    output = (unsigned char*)cJSON_malloc(size);
+    if (output == NULL)
+    {
+        return NULL;
+    }
+    cbor_write(item, output);
+    *length = size;
+
+    return output;
+}
+
+typedef struct
+{
+    const unsigned char *input;
+    const unsigned char *end;
+    char *text; /* nul terminated copy of the last text string */
+    size_t text_size;
+} cbor_decoder;
+
+static cJSON_bool cbor_read_big_endian(cbor_decoder * const decoder, size_t bytes, uint64_t * const value)
+{
+    if ((size_t)(decoder->end - decoder->input) < bytes)
+    {
+        return false;
+    }
+
+    *value = 0;
+    while (bytes > 0)
+    {
+        *value = (*value << 8) | *decoder->input++;
+        bytes--;
+    }
+
+    return true;
+}
+
+/* Read the head of a data item. An indefinite length gives CBOR_INDEFINITE as info. */
+static cJSON_bool cbor_read_head(cbor_decoder * const decoder, unsigned char * const major, unsigned char * const info, uint64_t * const argument)
+{
+    if (decoder->input >= decoder->end)
+    {
+        return false;
+    }
+
+    *major = (unsigned char)(*decoder->input >> 5);
+    *info = (unsigned char)(*decoder->input & 0x1F);
+    decoder->input++;
+
+    if (*info < 24)
+    {
+        *argument = *info;
+        return true;
+    }
+    switch (*info)
+    {
+        case 24:
+            return cbor_read_big_endian(decoder, 1, argument);
+        case 25:
+            return cbor_read_big_endian(decoder, 2, argument);
+        case 26:
+            return cbor_read_big_endian(decoder, 4, argument);
+        case 27:
+            return cbor_read_big_endian(decoder, 8, argument);
+        case CBOR_INDEFINITE:
+            *argument = 0;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Copy a text string of the given length into decoder->text. cJSON strings can't contain '\0'. */
+static cJSON_bool cbor_read_text(cbor_decoder * const decoder, const uint64_t length)
+{
+    if ((uint64_t)(decoder->end - decoder->input) < length)
+    {
+        return false;
+    }
+    if (memchr(decoder->input, '\0', (size_t)length) != NULL)
+    {
+        return false;
+    }
+
+    if ((size_t)length >= decoder->text_size)
+    {
+        size_t size = (decoder->text_size < 64) ? 64 : decoder->text_size;
+        while (size <= (size_t)length)
+        {
+            size *= 2;
+        }
+        if (decoder->text != NULL)
+        {
+            cJSON_free(decoder->text);
+        }
+        decoder->text = (char*)cJSON_malloc(size);
+        decoder->text_size = (decoder->text != NULL) ? size : 0;
+        if (decoder->text == NULL)
+        {
+            return false;
+        }
+    }
+
+    memcpy(decoder->text, decoder->input, (size_t)length);
+    decoder->text[length] = '\0';
+    decoder->input += length;
+
+    return true;
+}
+
+/* IEEE 754 half precision, see RFC 8949 appendix D */
+static double cbor_half_to_double(const unsigned int half)
+{
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+    uint32_t bits = 0;
+    float number = 0;
+
+    if (exponent == 0)
+    {
+        /* subnormal, mantissa * 2^-24 */
+        double value = (double)mantissa / 16777216.0;
+        return (half & 0x8000) ? -value : value;
+    }
+
+    /* same value as a float: rebias the exponent, infinity and NaN keep an exponent of all ones */
+    exponent = (exponent == 31) ? 0xFF : (exponent - 15 + 127);
+    bits = ((uint32_t)(half & 0x8000) << 16) | (exponent << 23) | (mantissa << 13);
+    memcpy(&number, &bits, sizeof(number));
+
+    return (double)number;
+}
+
+static cJSON *cbor_decode(cbor_decoder * const decoder, const size_t depth)
+{
+    unsigned char major = 0;
+    unsigned char info = 0;
+    uint64_t argument = 0;
+    cJSON *item = NULL;
+
+    if (depth >= CJSON_NESTING_LIMIT)
+    {
+        return NULL;
+    }
+
+    if (!cbor_read_head(decoder, &major, &info, &argument))
+    {
+        return NULL;
+    }
+    /* indefinite lengths are only supported for arrays and maps */
+    if ((info == CBOR_INDEFINITE) && (major != CBOR_ARRAY) && (major != CBOR_MAP))
+    {
+        return NULL;
+    }
+
+    switch (major)
+    {
+        case CBOR_UNSIGNED:
+            return cJSON_CreateNumber((double)argument);
+
+        case CBOR_NEGATIVE:
+            return cJSON_CreateNumber(-1.0 - (double)argument);
+
+        case CBOR_TEXT:
+            if (!cbor_read_text(decoder, argument))
+            {
+                return NULL;
+            }
+            return cJSON_CreateString(decoder->text);
+
+        case CBOR_ARRAY:
+        case CBOR_MAP:
+        {
+            uint64_t i = 0;
+
+            /* every element takes at least one byte, don't loop for nothing on bogus lengths */
+            if ((info != CBOR_INDEFINITE) && (argument > (uint64_t)(decoder->end - decoder->input)))
+            {
+                return NULL;
+            }
+
+            item = (major == CBOR_MAP) ? cJSON_CreateObject() : cJSON_CreateArray();
+            if (item == NULL)
+            {
+                return NULL;
+            }
+
+            for (i = 0; (info == CBOR_INDEFINITE) || (i < argument); i++)
+            {
+                cJSON *child = NULL;
+
+                if (info == CBOR_INDEFINITE)
+                {
+                    if (decoder->input >= decoder->end)
+                    {
+                        goto fail;
+                    }
+                    if (*decoder->input == CBOR_BREAK)
+                    {
+                        decoder->input++;
+                        break;
+                    }
+                }
+
+                if (major == CBOR_MAP)
+                {
+                    unsigned char key_major = 0;
+                    unsigned char key_info = 0;
+                    uint64_t key_length = 0;
+                    char *key = NULL;
+
+                    /* keys have to be text strings of definite length */
+                    if (!cbor_read_head(decoder, &key_major, &key_info, &key_length)
+                            || (key_major != CBOR_TEXT) || (key_info == CBOR_INDEFINITE)
+                            || !cbor_read_text(decoder, key_length))
+                    {
+                        goto fail;
+                    }
+                    /* the value reuses decoder->text */
+                    key = (char*)cJSON_malloc((size_t)key_length + 1);
+                    if (key == NULL)
+                    {
+                        goto fail;
+                    }
+                    memcpy(key, decoder->text, (size_t)key_length + 1);
+
+                    child = cbor_decode(decoder, depth + 1);
+                    if (child != NULL)
+                    {
+                        cJSON_AddItemToObject(item, key, child);
+                    }
+                    cJSON_free(key);
+                    if (child == NULL)
+                    {
+                        goto fail;
+                    }
+                }
+                else
+                {
+                    child = cbor_decode(decoder, depth + 1);
+                    if (child == NULL)
+                    {
+                        goto fail;
+                    }
+                    cJSON_AddItemToArray(item, child);
+                }
+            }
+
+            return item;
+        }
+
+        case CBOR_TAG:
+            /* tags only add meaning to the item that follows, which is taken as is */
+            return cbor_decode(decoder, depth + 1);
+
+        case CBOR_SIMPLE:
+            switch (info)
+            {
+                case CBOR_FALSE & 0x1F:
+                    return cJSON_CreateFalse();
+                case CBOR_TRUE & 0x1F:
+                    return cJSON_CreateTrue();
+                case CBOR_NULL & 0x1F:
+                case CBOR_UNDEFINED & 0x1F:
+                    return cJSON_CreateNull();
+                case CBOR_HALF & 0x1F:
+                    return cJSON_CreateNumber(cbor_half_to_double((unsigned int)argument));
+                case CBOR_FLOAT & 0x1F:
+                {
+                    uint32_t bits = (uint32_t)argument;
+                    float number = 0;
+                    memcpy(&number, &bits, sizeof(number));
+                    return cJSON_CreateNumber((double)number);
+                }
+                case CBOR_DOUBLE & 0x1F:
+                {
+                    double number = 0;
+                    memcpy(&number, &argument, sizeof(number));
+                    return cJSON_CreateNumber(number);
+                }
+                default:
+                    /* other simple values */
+                    return NULL;
+            }
+
+        default:
+            /* byte strings have no JSON equivalent */
+            return NULL;
+    }
+
+fail:
+    cJSON_Delete(item);
+
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON *) cJSONUtils_DecodeCBOR(const unsigned char *data, size_t length)
+{
+    cbor_decoder decoder;
+    cJSON *item = NULL;
+
+    if (data == NULL)
+    {
+        return NULL;
+    }
+
+    decoder.input = data;
+    decoder.end = data + length;
+    decoder.text = NULL;
+    decoder.text_size = 0;
+
+    item = cbor_decode(&decoder, 0);
+    if (decoder.text != NULL)
+    {
+        cJSON_free(decoder.text);
+    }
+    /* exactly one data item */
+    if ((item != NULL) && (decoder.input != decoder.end))
+    {
+        cJSON_Delete(item);
+        return NULL;
+    }
+
+    return item;
+}
+
+/* JSON Merge Patch (RFC 7386) */
+
+/* The member of object with the given key. Two versions of a document usually have their keys
+ * in the same order, so guess, the member at the same position, is tried before a lookup. */
+static cJSON *find_member(const cJSON * const object, cJSON * const guess, const char * const key)
+{
+    if ((guess != NULL) && (guess->string != NULL) && (strcmp(guess->string, key) == 0))
+    {
+        return guess;
+    }
+
+    return cJSON_GetObjectItemCaseSensitive(object, key);
+}
+
+static cJSON *merge_patch(cJSON *target, const cJSON * const patch)
+{
+    const cJSON *member = NULL;
+
+    if (!cJSON_IsObject(patch))
+    {
+        cJSON_Delete(target);
+        return cJSON_Duplicate(patch, true);
+    }
+
+    if (!cJSON_IsObject(target))
+    {
+        cJSON_Delete(target);
+        target = cJSON_CreateObject();
+        if (target == NULL)
+        {
+            return NULL;
+        }
+    }
+    /* members are patched in place, they have to be target's own (see cJSON_Fork) */
+    if (!cJSON_Unshare(target))
+    {
+        return target;
+    }
+
+    for (member = patch->child; member != NULL; member = member->next)
+    {
+        cJSON *existing = NULL;
+        cJSON *replacement = NULL;
+
+        if (member->string == NULL)
+        {
+            continue;
+        }
+        if (cJSON_IsNull(member))
+        {
+            cJSON_DeleteItemFromObjectCaseSensitive(target, member->string);
+            continue;
+        }
+
+        existing = cJSON_GetObjectItemCaseSensitive(target, member->string);
+        if (cJSON_IsObject(existing) && cJSON_IsObject(member))
+        {
+            /* patched in place */
+            merge_patch(existing, member);
+            continue;
+        }
+
+        replacement = merge_patch(NULL, member);
+        if (replacement == NULL)
+        {
+            continue;
+        }
+        if (existing != NULL)
+        {
+            cJSON_ReplaceItemInObjectCaseSensitive(target, member->string, replacement);
+        }
+        else
+        {
+            cJSON_AddItemToObject(target, member->string, replacement);
+        }
+    }
+
+    return target;
+}
+
+CJSON_PUBLIC(cJSON *) cJSONUtils_MergePatch(cJSON *target, const cJSON * const patch)
+{
+    if (patch == NULL)
+    {
+        return target;
+    }
+
+    return merge_patch(target, patch);
+}
+
+CJSON_PUBLIC(cJSON *) cJSONUtils_GenerateMergePatch(const cJSON * const from, const cJSON * const to)
+{
+    cJSON *patch = NULL;
+    cJSON *from_member = NULL;
+    cJSON *to_member = NULL;
+
+    if (to == NULL)
+    {
+        return NULL;
+    }
+    if (!cJSON_IsObject(from) || !cJSON_IsObject(to))
+    {
+        return cJSON_Duplicate(to, true);
+    }
+
+    patch = cJSON_CreateObject();
+    if (patch == NULL)
+    {
+        return NULL;
+    }
+
+    /* removed members, walking both objects side by side for the guesses */
+    for (from_member = from->child, to_member = to->child; from_member != NULL; from_member = from_member->next)
+    {
+        if ((from_member->string != NULL) && (find_member(to, to_member, from_member->string) == NULL))
+        {
+            cJSON_AddItemToObject(patch, from_member->string, cJSON_CreateNull());
+        }
+        if (to_member != NULL)
+        {
+            to_member = to_member->next;
+        }
+    }
+
+    /* added and changed members */
+    for (to_member = to->child, from_member = from->child; to_member != NULL; to_member = to_member->next)
+    {
+        cJSON *previous = NULL;
+        cJSON *change = NULL;
+
+        if (to_member->string != NULL)
+        {
+            previous = find_member(from, from_member, to_member->string);
+            if (previous == NULL)
+            {
+                change = cJSON_Duplicate(to_member, true);
+            }
+            else if (cJSON_IsObject(previous) && cJSON_IsObject(to_member))
+            {
+                change = cJSONUtils_GenerateMergePatch(previous, to_member);
+                if ((change != NULL) && (change->child == NULL))
+                {
+                    /* unchanged */
+                    cJSON_Delete(change);
+                    change = NULL;
+                }
+            }
+            else if (!cJSON_Compare(previous, to_member, true))
+            {
+                change = cJSON_Duplicate(to_member, true);
+            }
+
+            if (change != NULL)
+            {
+                cJSON_AddItemToObject(patch, to_member->string, change);
+            }
+        }
+        if (from_member != NULL)
+        {
+            from_member = from_member->next;
+        }
+    }
+
+    return patch;
+}
@@ -0,0 +1,71 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef cJSON_Utils__h
+#define cJSON_Utils__h
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "cJSON.h"
+
+/* Find an item by JSON Pointer (RFC6901), e.g. "/devices/0/name". "" is object itself.
+ * Returns NULL if the pointer is invalid or doesn't lead to an item. */
+CJSON_PUBLIC(cJSON *) cJSONUtils_GetPointer(cJSON * const object, const char *pointer);
+
+/* Compiled JSON Pointers. Compile the pointers to the fields you need once, then look all of them up
+ * with a single walk over a document: every array and object on the way is visited once, no matter
+ * how many of the fields are in it. Pointers with a common prefix share it, e.g. "/a/b" and "/a/c"
+ * both go through "/a" once. */
+typedef struct cJSONUtils_Paths cJSONUtils_Paths;
+/* Returns NULL if one of the pointers is invalid or on allocation failure. */
+CJSON_PUBLIC(cJSONUtils_Paths *) cJSONUtils_CompilePaths(const char * const *pointers, size_t count);
+/* results has to have room for count items, results[i] is set to the item pointers[i] leads to, or NULL.
+ * Returns the number of pointers that were found. Can be called from several threads at once. */
+CJSON_PUBLIC(size_t) cJSONUtils_EvaluatePaths(const cJSONUtils_Paths *paths, cJSON * const object, cJSON **results);
+CJSON_PUBLIC(void) cJSONUtils_DeletePaths(cJSONUtils_Paths *paths);
+
+/* CBOR (RFC 8949), a binary encoding of the same data model that is usually a good deal smaller than JSON text.
+ * Numbers that are whole become integers, others the smallest float that holds them exactly; NaN and infinity
+ * become null like in cJSON_Print. Returns a buffer of *length bytes to be freed with cJSON_free, or NULL if item
+ * contains raw JSON, is nested deeper than CJSON_NESTING_LIMIT or memory runs out. */
+CJSON_PUBLIC(unsigned char *) cJSONUtils_EncodeCBOR(const cJSON * const item, size_t *length);
+/* data has to be exactly one CBOR data item. Tags are ignored, undefined becomes null. Returns NULL for byte
+ * strings, indefinite length strings, keys that aren't text, strings containing '\0' and other simple values,
+ * which cJSON can't represent. */
+CJSON_PUBLIC(cJSON *) cJSONUtils_DecodeCBOR(const unsigned char *data, size_t length);
+
+/* JSON Merge Patch (RFC 7386): a patch is a document with the members that changed, null for the ones that
+ * were removed. Keys are case sensitive. A merge patch can't set a member to null, and replaces arrays whole. */
+/* Apply patch to target and return the result. That can be a different item than target (e.g. if patch isn't
+ * an object), which is then deleted, so always use the returned item. patch isn't changed. */
+CJSON_PUBLIC(cJSON *) cJSONUtils_MergePatch(cJSON *target, const cJSON * const patch);
+/* The patch that turns from into to. If both are objects and nothing changed, it is an empty object. */
+CJSON_PUBLIC(cJSON *) cJSONUtils_GenerateMergePatch(const cJSON * const from, const cJSON * const to);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -9,6 +9,24 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include "cJSON.h"
+
+/// Formats of the encrypted envelope around a payload. Every peer can read
+/// CIA_ENVELOPE_CBC, so use CIA_ENVELOPE_GCM only for devices known to
+/// support it.
+///
+/// Anyone can make a v1 message that decrypts, so once a device has sent a
+/// v2 message, only accept v2 from it: pass CIA_ENVELOPE_GCM as minEnvelope
+/// to decryptPayloadWithEnvelope or decryptJsonPayload. Accept v1
+/// (CIA_ENVELOPE_CBC) only from devices that never used v2.
+typedef enum {
+    /// v1: [16 byte IV][AES-128-CBC of the padded message], no integrity check
+    /// besides a pattern in the padding.
+    CIA_ENVELOPE_CBC = 1,
+    /// v2: [0x02][12 byte nonce][AES-128-GCM of the message][16 byte tag],
+    /// authenticated, so tampered or truncated messages are rejected.
+    CIA_ENVELOPE_GCM = 2,
+} CiaEnvelope;
 
 /**
  * @brief      Calculate the MD5 digest of input string
@@ -34,7 +52,36 @@ char* md5String(char* inStr, char* outStr);
 char* encryptPayload(const char *in, const uint8_t *key);
 
 /**
- * @brief      Decode the base64 encoded string and decrypt the data and remove the padding
+ * @brief      Encrypt the input data like encryptPayload, in the given envelope
+ *
+ * @param[in]  in        The string form of JSON contents
+ * @param[in]  key       The crypto key
+ * @param[in]  envelope  The envelope format the device supports
+ *
+ * @return     Pointer to the buffer that stores the base64-encoded string or NULL if failed
+ *             It is the caller's responsibility to free this buffer.
+ */
+char* encryptPayloadWithEnvelope(const char *in, const uint8_t *key, CiaEnvelope envelope);
+
+/**
+ * @brief      Encrypt many payloads like encryptPayload, e.g. one command for
+ *             each of many devices. The messages are encrypted side by side,
+ *             which is several times faster than one after the other.
+ *
+ * @param[in]  in     The string forms of JSON contents
+ * @param[in]  keys   The crypto key of each payload
+ * @param[out] out    The base64-encoded string of each payload, or NULL for a
+ *                    payload that failed. It is the caller's responsibility to
+ *                    free these buffers.
+ * @param[in]  count  The number of payloads
+ *
+ * @return     The number of payloads encrypted
+ */
+size_t encryptPayloads(const char *const *in, const uint8_t *const *keys, char **out, size_t count);
+
+/**
+ * @brief      Decode the base64 encoded string and decrypt the data and remove the padding.
+ *             Both envelope formats are accepted.
  *
  * @param[in]  payload  The input payload
  * @param[in]  key      The crypto key
@@ -43,6 +90,56 @@ char* encryptPayload(const char *in, const uint8_t *key);
  *             It is the caller's responsibility to free this buffer.
  */
 char* decryptPayload(const char *payload, const uint8_t *key);
+
+/**
+ * @brief      Decrypt the payload like decryptPayload, unless its envelope is
+ *             older than minEnvelope
+ *
+ * @param[in]  payload      The input payload
+ * @param[in]  key          The crypto key
+ * @param[in]  minEnvelope  The oldest envelope format accepted from the device
+ *
+ * @return     Pointer to the buffer that stores the plain string of JSON content
+ *             It is the caller's responsibility to free this buffer.
+ */
+char* decryptPayloadWithEnvelope(const char *payload, const uint8_t *key, CiaEnvelope minEnvelope);
+
+/**
+ * @brief      Encrypt a JSON document like encryptPayload, either as JSON text or
+ *             as CBOR, which is smaller and so less to encrypt and transfer.
+ *             The envelope marks CBOR messages, but peers that don't know the
+ *             mark misread it as a huge length and may crash, so only use CBOR
+ *             towards peers that sent CBOR themselves (see decryptJsonPayload).
+ *
+ * @param[in]  json      The JSON document
+ * @param[in]  key       The crypto key
+ * @param[in]  useCbor   Send CBOR instead of JSON text
+ * @param[in]  envelope  The envelope format the device supports
+ *
+ * @return     Pointer to the buffer that stores the base64-encoded string or NULL if failed
+ *             It is the caller's responsibility to free this buffer.
+ */
+char* encryptJsonPayload(const cJSON *json, const uint8_t *key, bool useCbor, CiaEnvelope envelope);
+
+/**
+ * @brief      Decrypt a payload like decryptPayload and parse the JSON text or
+ *             CBOR in it. decryptPayload accepts both encodings as well, it
+ *             returns CBOR messages converted to JSON text.
+ *
+ * @param[in]  payload      The input payload
+ * @param[in]  key          The crypto key
+ * @param[in]  minEnvelope  The oldest envelope format accepted from the device
+ * @param[out] isCbor       If not NULL, whether the message was CBOR, so the reply
+ *                          can use the same encoding
+ * @param[out] envelope     If not NULL, the envelope format of the message, so
+ *                          the reply can use the same one, and later messages
+ *                          can be held to it
+ *
+ * @return     The JSON document or NULL if failed
+ *             It is the caller's responsibility to free it with cJSON_Delete.
+ */
+cJSON* decryptJsonPayload(const char *payload, const uint8_t *key, CiaEnvelope minEnvelope,
+                          bool *isCbor, CiaEnvelope *envelope);
  
 
 #endif // SRC_CRYPTO_H
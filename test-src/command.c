@@ -0,0 +1,77 @@
+// Copyright (C) 2017 BRK Brands, Inc. All Rights Reserved.
+/// @file
+/// The encoders declared by \ref ONELINK_COMMANDS.
+
+#include "command.h"
+#include <string.h>
+
+/// Copy text, which needs no escaping.
+/// @return the end of the copied text.
+static char *appendLiteral(char *dest, const char *text, size_t length)
+{
+    memcpy(dest, text, length);
+    return dest + length;
+}
+
+/// Write str as a quoted JSON string. Escapes the same characters as
+/// cJSON_PrintUnformatted does, so the output does not change.
+/// @return the end of the written string, or NULL if str is NULL or has more
+///         than maxLength characters.
+static char *appendString(char *dest, const char *str, size_t maxLength)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+
+    if (str == NULL || memchr(str, '\0', maxLength + 1) == NULL) {
+        return NULL;
+    }
+
+    *dest++ = '"';
+    for (const unsigned char *src = (const unsigned char *)str; *src != '\0'; src++) {
+        switch (*src) {
+            case '"':  *dest++ = '\\'; *dest++ = '"';  break;
+            case '\\': *dest++ = '\\'; *dest++ = '\\'; break;
+            case '\b': *dest++ = '\\'; *dest++ = 'b';  break;
+            case '\f': *dest++ = '\\'; *dest++ = 'f';  break;
+            case '\n': *dest++ = '\\'; *dest++ = 'n';  break;
+            case '\r': *dest++ = '\\'; *dest++ = 'r';  break;
+            case '\t': *dest++ = '\\'; *dest++ = 't';  break;
+            default:
+                if (*src < 32) {
+                    dest = appendLiteral(dest, "\\u00", 4);
+                    *dest++ = hexDigits[*src >> 4];
+                    *dest++ = hexDigits[*src & 0xf];
+                } else {
+                    *dest++ = (char)*src;
+                }
+                break;
+        }
+    }
+    *dest++ = '"';
+    return dest;
+}
+
+#define ENCODE_LITERAL(text) \
+    dest = appendLiteral(dest, text, sizeof(text) - 1);
+#define ENCODE_STRING(member, maxLength) \
+    dest = appendString(dest, command->member, maxLength); \
+    if (dest == NULL) { \
+        return 0; \
+    }
+#define ENCODE_BOOL(member) \
+    dest = command->member ? appendLiteral(dest, "true", 4) : appendLiteral(dest, "false", 5);
+
+/// The buffer is at least as big as the longest possible output, so only the
+/// string lengths have to be checked while writing.
+#define COMMAND_DEFINE_ENCODER(Name, FIELDS) \
+    size_t encode##Name##Command(const Name##Command *command, char *buffer, size_t size) \
+    { \
+        char *dest = buffer; \
+        if (command == NULL || buffer == NULL || size < (size_t)Name##CommandMaxLength + 1) { \
+            return 0; \
+        } \
+        FIELDS(ENCODE_LITERAL, ENCODE_STRING, ENCODE_BOOL) \
+        *dest = '\0'; \
+        return (size_t)(dest - buffer); \
+    }
+
+ONELINK_COMMANDS(COMMAND_DEFINE_ENCODER)
@@ -0,0 +1,69 @@
+// Copyright (C) 2017 BRK Brands, Inc. All Rights Reserved.
+/// @file
+/// Encoders for the JSON commands sent to the Onelink application. The shape
+/// of every command is known at compile time, so instead of building a cJSON
+/// tree and printing it, each command has an encoder that writes its JSON text
+/// straight into a buffer supplied by the caller, without allocating memory.
+
+#ifndef PRIME_COMMAND_H
+#define PRIME_COMMAND_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/// Longest SSID allowed by 802.11.
+#define COMMAND_SSID_MAX_LEN    32
+/// Longest WPA passphrase.
+#define COMMAND_PASSWD_MAX_LEN  63
+
+/// The pieces of the JSON text of a command, in order. LITERAL("text") is
+/// copied as is, STRING(member, maxLength) is a string member of the command
+/// that is quoted and escaped, and BOOL(member) is written as true or false.
+#define SETUP_WIFI_FIELDS(LITERAL, STRING, BOOL) \
+    LITERAL("{\"wifi\":{\"ssid\":") STRING(ssid, COMMAND_SSID_MAX_LEN) \
+    LITERAL(",\"passwd\":") STRING(passwd, COMMAND_PASSWD_MAX_LEN) LITERAL("}}")
+
+#define FACTORY_RESET_FIELDS(LITERAL, STRING, BOOL) \
+    LITERAL("{\"reset\":") BOOL(reset) LITERAL("}")
+
+#define SELF_DIAGNOSIS_FIELDS(LITERAL, STRING, BOOL) \
+    LITERAL("{\"selfDiagosis\":") BOOL(selfDiagosis) LITERAL("}")
+
+/// Every command, as X(Name, FIELDS). Adding a command here declares the
+/// NameCommand structure, NameCommandMaxLength and encodeNameCommand.
+#define ONELINK_COMMANDS(X) \
+    X(SetupWifi, SETUP_WIFI_FIELDS) \
+    X(FactoryReset, FACTORY_RESET_FIELDS) \
+    X(SelfDiagnosis, SELF_DIAGNOSIS_FIELDS)
+
+#define COMMAND_NO_MEMBER(...)
+#define COMMAND_STRING_MEMBER(member, maxLength) const char *member;
+#define COMMAND_BOOL_MEMBER(member) bool member;
+
+/// Worst case: every byte of a string needs a six character escape.
+#define COMMAND_LITERAL_LENGTH(text) (sizeof(text) - 1) +
+#define COMMAND_STRING_LENGTH(member, maxLength) (2 + 6 * (maxLength)) +
+#define COMMAND_BOOL_LENGTH(member) (sizeof("false") - 1) +
+
+/// The values of a command's members, e.g. SetupWifiCommand. Strings must not
+/// be NULL or longer than the maxLength given in the FIELDS list.
+///
+/// NameCommandMaxLength is the length of the longest JSON text the command can
+/// produce, so a buffer of NameCommandMaxLength + 1 bytes always fits.
+///
+/// encodeNameCommand writes the nul terminated JSON text to buffer.
+/// @param[in]  command the values of the command.
+/// @param[out] buffer where the JSON text is written.
+/// @param[in]  size size of buffer, at least NameCommandMaxLength + 1.
+/// @return the length of the JSON text, or 0 if buffer is too small or a
+///         string is NULL or too long.
+#define COMMAND_DECLARE(Name, FIELDS) \
+    typedef struct Name##Command { \
+        FIELDS(COMMAND_NO_MEMBER, COMMAND_STRING_MEMBER, COMMAND_BOOL_MEMBER) \
+    } Name##Command; \
+    enum { Name##CommandMaxLength = FIELDS(COMMAND_LITERAL_LENGTH, COMMAND_STRING_LENGTH, COMMAND_BOOL_LENGTH) 0 }; \
+    size_t encode##Name##Command(const Name##Command *command, char *buffer, size_t size);
+
+ONELINK_COMMANDS(COMMAND_DECLARE)
+
+#endif // PRIME_COMMAND_H
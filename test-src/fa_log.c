@@ -13,6 +13,9 @@
 #include <string.h>
 #include <stdbool.h>
 #include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
 
 #include "config.h"
 #include "fa_log.h"
@@ -29,6 +32,21 @@
 #endif
 #endif
 
+/// Storage class for data that every thread keeps its own copy of.
+#if __STDC_VERSION__ >= 201112L
+#define FA_THREAD_LOCAL _Thread_local
+#else
+#define FA_THREAD_LOCAL __thread
+#endif
+
+/// Prefer the coarse clock. It is read from the vDSO without entering the
+/// kernel and a log timestamp does not need better than tick resolution.
+#if defined(CLOCK_REALTIME_COARSE)
+#define FA_LOG_CLOCK CLOCK_REALTIME_COARSE
+#else
+#define FA_LOG_CLOCK CLOCK_REALTIME
+#endif
+
 
 static const char *logLevelString(FaLogLevel level)
 {
@@ -79,9 +97,308 @@ static void faLogDoDefaultInitialization(void)
 /// to make sure the system is initialized before continuing.
 static bool g_LogIsInitialized = false;
 
+/// How log records are rendered. See \ref faLogSetFormat.
+static FaLogFormat g_logFormat = FA_LOG_FORMAT_TEXT;
+
+/// The name of a level as it appears in JSON records. Unlike \ref
+/// logLevelString these are not shortened to line up in a text console.
+static const char *logLevelName(FaLogLevel level)
+{
+    switch (level) {
+        case FA_LOG_LEVEL_CRITICAL:
+            return "CRITICAL";
+        case FA_LOG_LEVEL_ERROR:
+            return "ERROR";
+        case FA_LOG_LEVEL_WARNING:
+            return "WARNING";
+        case FA_LOG_LEVEL_NOTICE:
+            return "NOTICE";
+        case FA_LOG_LEVEL_INFO:
+            return "INFO";
+        case FA_LOG_LEVEL_DEBUG:
+        case FA_LOG_NUM_LEVELS:
+            return "DEBUG";
+    }
+    return "";
+}
+
+/// Per-thread state used to stamp JSON records. The calendar part of the
+/// timestamp is only reformatted when the second changes, so gmtime_r and the
+/// digit formatting stay out of the common path. The thread id is looked up
+/// once per thread.
+typedef struct LogThreadCache {
+    time_t second;  ///< The second that \ref text was formatted for.
+    char text[sizeof("1970-01-01T00:00:00")]; ///< Formatted UTC date and time.
+    long tid;       ///< Kernel thread id, 0 until looked up.
+} LogThreadCache;
+
+static FA_THREAD_LOCAL LogThreadCache t_logCache = { (time_t)-1, "", 0 };
+
+/// Write the current UTC time as "YYYY-MM-DDTHH:MM:SS.mmmZ" to \p dest.
+/// @return Pointer to the character after the last one written.
+static char *putTimestamp(char *dest, const char *end)
+{
+    struct timespec now;
+    if (clock_gettime(FA_LOG_CLOCK, &now) != 0) {
+        now.tv_sec = time(NULL);
+        now.tv_nsec = 0;
+    }
+    if (now.tv_sec != t_logCache.second) {
+        struct tm tm;
+        gmtime_r(&now.tv_sec, &tm);
+        strftime(t_logCache.text, sizeof(t_logCache.text), "%Y-%m-%dT%H:%M:%S", &tm);
+        t_logCache.second = now.tv_sec;
+    }
+    size_t len = strlen(t_logCache.text);
+    if ((size_t)(end - dest) < len + sizeof(".000Z")) {
+        return dest;
+    }
+    memcpy(dest, t_logCache.text, len);
+    dest += len;
+    unsigned ms = (unsigned)(now.tv_nsec / 1000000);
+    *dest++ = '.';
+    *dest++ = (char)('0' + ms / 100);
+    *dest++ = (char)('0' + ms / 10 % 10);
+    *dest++ = (char)('0' + ms % 10);
+    *dest++ = 'Z';
+    return dest;
+}
+
+/// Copy \p src to \p dest, up to but not past \p end.
+/// @return Pointer to the character after the last one copied.
+static char *putString(char *dest, const char *end, const char *src)
+{
+    while (*src != '\0' && dest < end) {
+        *dest++ = *src++;
+    }
+    return dest;
+}
+
+/// Write an unsigned number in decimal to \p dest.
+/// @return Pointer to the character after the last digit written.
+static char *putUnsigned(char *dest, const char *end, unsigned long value)
+{
+    char digits[20];
+    size_t n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (n > 0 && dest < end) {
+        *dest++ = digits[--n];
+    }
+    return dest;
+}
+
+/// Write \p src as the contents of a JSON string (without the quotes),
+/// escaping as required by RFC 8259. Bytes >= 0x80 are passed through as
+/// they are expected to be UTF-8 already. If \p end is reached the text is
+/// truncated, but never in the middle of an escape sequence.
+/// @return Pointer to the character after the last one written.
+static char *putJsonString(char *dest, const char *end, const char *src)
+{
+    static const char hex[] = "0123456789abcdef";
+    for (; *src != '\0'; ++src) {
+        unsigned char c = (unsigned char)*src;
+        char esc = 0;
+        switch (c) {
+            case '"':  esc = '"';  break;
+            case '\\': esc = '\\'; break;
+            case '\b': esc = 'b';  break;
+            case '\f': esc = 'f';  break;
+            case '\n': esc = 'n';  break;
+            case '\r': esc = 'r';  break;
+            case '\t': esc = 't';  break;
+            default: break;
+        }
+        if (esc != 0) {
+            if (end - dest < 2) {
+                break;
+            }
+            *dest++ = '\\';
+            *dest++ = esc;
+        } else if (c < 0x20) {
+            if (end - dest < 6) {
+                break;
+            }
+            memcpy(dest, "\\u00", 4);
+            dest[4] = hex[c >> 4];
+            dest[5] = hex[c & 0xf];
+            dest += 6;
+        } else {
+            if (dest >= end) {
+                break;
+            }
+            *dest++ = (char)c;
+        }
+    }
+    return dest;
+}
+
+/// Render a record in the classic "file:line: [LEVEL] message" form.
+/// @return false if nothing usable could be written.
+static bool formatTextRecord(char *buffer, size_t size, const char *fname, uint32_t line,
+                             FaLogLevel severity, const char *format, va_list args)
+{
+    int pre_len = snprintf(buffer, size, "%s:%d: [%s] ", fname, line, logLevelString(severity));
+    if (pre_len < 0) {
+        return false; // Some random problem. We are in a world of hurt if this fails.
+    }
+    int main_len = vsnprintf(&buffer[pre_len], size - (unsigned)pre_len, format, args);
+    if (main_len < 0) {
+        // Something bad and very unexpected happened, use what we previously put into the buffer.
+        buffer[pre_len] = '\0';
+    }
+    return true;
+}
+
+/// Render a record as a single line JSON object. The message is formatted
+/// first and then escaped into \p buffer with the rest of the fields. The
+/// record is always closed properly, even if the message had to be cut short.
+/// @return false if nothing usable could be written.
+static bool formatJsonRecord(char *buffer, size_t size, const char *fname, uint32_t line,
+                             FaLogLevel severity, const char *format, va_list args)
+{
+    char msg[1024];
+    if (vsnprintf(msg, sizeof(msg), format, args) < 0) {
+        msg[0] = '\0';
+    }
+    if (t_logCache.tid == 0) {
+        t_logCache.tid = (long)syscall(SYS_gettid);
+    }
+
+    // Keep room for the closing "}\0 so the output is always valid JSON.
+    static const char closing[] = "\"}";
+    char *end = buffer + size - sizeof(closing);
+    char *dest = buffer;
+    dest = putString(dest, end, "{\"ts\":\"");
+    dest = putTimestamp(dest, end);
+    dest = putString(dest, end, "\",\"tid\":");
+    dest = putUnsigned(dest, end, (unsigned long)t_logCache.tid);
+    dest = putString(dest, end, ",\"level\":\"");
+    dest = putString(dest, end, logLevelName(severity));
+    dest = putString(dest, end, "\",\"file\":\"");
+    dest = putJsonString(dest, end, fname ? fname : "");
+    dest = putString(dest, end, "\",\"line\":");
+    dest = putUnsigned(dest, end, line);
+    dest = putString(dest, end, ",\"msg\":\"");
+    dest = putJsonString(dest, end, msg);
+    memcpy(dest, closing, sizeof(closing));
+    return true;
+}
+
+/// Logging metrics for one thread. Only the owning thread writes to the
+/// counters, so an update is a plain load and store; the relaxed atomics just
+/// keep \ref faLogGetMetrics from reading torn values.
+typedef struct LogThreadMetrics {
+    FaLogMetrics counts;
+    struct LogThreadMetrics *next; ///< Next block in \ref g_metricsList.
+} LogThreadMetrics;
+
+/// Add \p N to the per-thread counter \p FIELD.
+#define METRIC_ADD(FIELD, N) \
+    __atomic_store_n(&(FIELD), __atomic_load_n(&(FIELD), __ATOMIC_RELAXED) + (N), __ATOMIC_RELAXED)
+
+/// Protects \ref g_metricsList and \ref g_retiredMetrics.
+static pthread_mutex_t g_metricsLock = PTHREAD_MUTEX_INITIALIZER;
+/// Metrics blocks of all live threads that have logged something.
+static LogThreadMetrics *g_metricsList;
+/// Totals of the threads that have exited.
+static FaLogMetrics g_retiredMetrics;
+/// Used to fold a thread's block into \ref g_retiredMetrics when it exits.
+static pthread_key_t g_metricsKey;
+static pthread_once_t g_metricsKeyOnce = PTHREAD_ONCE_INIT;
+/// The calling thread's metrics block, NULL until it first logs.
+static FA_THREAD_LOCAL LogThreadMetrics *t_metrics;
+
+/// Add all counters of \p from to \p to.
+static void addMetrics(FaLogMetrics *to, const FaLogMetrics *from)
+{
+    const uint64_t *src = (const uint64_t *)from;
+    uint64_t *dst = (uint64_t *)to;
+    for (size_t i = 0; i < sizeof(FaLogMetrics) / sizeof(uint64_t); ++i) {
+        dst[i] += __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+    }
+}
+
+/// Thread exit handler: keep the counts, release the block.
+static void retireThreadMetrics(void *block)
+{
+    LogThreadMetrics *metrics = block;
+    pthread_mutex_lock(&g_metricsLock);
+    for (LogThreadMetrics **p = &g_metricsList; *p != NULL; p = &(*p)->next) {
+        if (*p == metrics) {
+            *p = metrics->next;
+            break;
+        }
+    }
+    addMetrics(&g_retiredMetrics, &metrics->counts);
+    pthread_mutex_unlock(&g_metricsLock);
+    // a later faLog on this thread, e.g. from another destructor, gets a new block
+    t_metrics = NULL;
+    free(metrics);
+}
+
+static void createMetricsKey(void)
+{
+    pthread_key_create(&g_metricsKey, retireThreadMetrics);
+}
+
+/// Get the calling thread's metrics block, registering one on first use.
+/// @return NULL if there was no memory for the block.
+static LogThreadMetrics *threadMetrics(void)
+{
+    if (t_metrics == NULL) {
+        LogThreadMetrics *metrics = calloc(1, sizeof(*metrics));
+        if (metrics == NULL) {
+            return NULL;
+        }
+        pthread_once(&g_metricsKeyOnce, createMetricsKey);
+        pthread_setspecific(g_metricsKey, metrics);
+        pthread_mutex_lock(&g_metricsLock);
+        metrics->next = g_metricsList;
+        g_metricsList = metrics;
+        pthread_mutex_unlock(&g_metricsLock);
+        t_metrics = metrics;
+    }
+    return t_metrics;
+}
+
+/// Nanoseconds on the monotonic clock.
+static uint64_t monotonicNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/// Account for the time spent in one \ref faLog call.
+static void recordLatency(LogThreadMetrics *metrics, uint64_t start)
+{
+    if (metrics == NULL) {
+        return;
+    }
+    uint64_t elapsed = monotonicNs() - start;
+    unsigned bucket = 0;
+    while (bucket < FA_LOG_LATENCY_BUCKETS - 1 && (elapsed >> (bucket + 1)) != 0) {
+        ++bucket;
+    }
+    METRIC_ADD(metrics->counts.latency[bucket], 1);
+    METRIC_ADD(metrics->counts.latencyTotalNs, elapsed);
+}
+
+/// Bit position of a single \ref FaLogDestination value.
+static unsigned destinationIndex(FaLogDestination destination)
+{
+    return (unsigned)__builtin_ctz((unsigned)destination);
+}
+
 // This is our main logging entrypoint.
 void faLog(const char *fname, uint32_t line, FaLogLevel severity, const char *format, ...)
 {
+    uint64_t start = monotonicNs();
+    LogThreadMetrics *metrics = threadMetrics();
+
     if (!g_LogIsInitialized) {
 #if defined(OS_LINUX)
         static pthread_once_t fa_log_initialized = PTHREAD_ONCE_INIT;
@@ -91,27 +408,47 @@ void faLog(const char *fname, uint32_t line, FaLogLevel severity, const char *fo
 #endif
     }
 
-
-    char buffer[1024];
-    int pre_len = snprintf(buffer, sizeof(buffer), "%s:%d: [%s] ", fname, line, logLevelString(severity));
-    if (pre_len < 0) {
-        return; // Some random problem. We are in a world of hurt if this fails.
+    // Check the destinations first so filtered records are never formatted.
+    FaLogDestinationSet destinations = getDestinations(fname, severity);
+    FaLogDestinationSet available = 0;
+#if defined(FEATURE_LOG_TO_STDOUT)
+    available |= FA_LOG_DEST_CONSOLE;
+#endif
+#if defined(FEATURE_LOG_TO_SYSLOG)
+    available |= FA_LOG_DEST_SYSLOG;
+#endif
+    if ((destinations & available) == 0) {
+        if (metrics) {
+            METRIC_ADD(metrics->counts.dropped[severity], 1);
+        }
+        recordLatency(metrics, start);
+        return;
     }
+
+    // JSON records need room for the extra fields and escaping of the message.
+    char buffer[2048];
     va_list args;
     va_start(args, format);
-    int main_len = vsnprintf(&buffer[pre_len], sizeof(buffer) - (unsigned)pre_len, format, args);
+    bool formatted;
+    if (g_logFormat == FA_LOG_FORMAT_JSON) {
+        formatted = formatJsonRecord(buffer, sizeof(buffer), fname, line, severity, format, args);
+    } else {
+        formatted = formatTextRecord(buffer, sizeof(buffer), fname, line, severity, format, args);
+    }
     va_end(args);
-    if (main_len < 0) {
-        // Something bad and very unexpected happened, use what we previously put into the buffer.
-        buffer[pre_len] = '\0';
+    if (!formatted) {
+        recordLatency(metrics, start);
+        return;
     }
-
-    FaLogDestinationSet destinations = getDestinations(fname, severity);
+    size_t length = strlen(buffer);
 
     if (destinations & FA_LOG_DEST_CONSOLE) {
 #if defined(FEATURE_LOG_TO_STDOUT)
         puts(buffer);
         fflush(stdout);
+        if (metrics) {
+            METRIC_ADD(metrics->counts.bytes[destinationIndex(FA_LOG_DEST_CONSOLE)], length + 1);
+        }
 //#else some test for a debug UART
 //   and code to send the buffer to the debug UART...
 #endif
@@ -120,8 +457,16 @@ void faLog(const char *fname, uint32_t line, FaLogLevel severity, const char *fo
 #if defined(FEATURE_LOG_TO_SYSLOG)
     if (destinations & FA_LOG_DEST_SYSLOG) {
         faSyslogLog(severity, buffer);
+        if (metrics) {
+            METRIC_ADD(metrics->counts.bytes[destinationIndex(FA_LOG_DEST_SYSLOG)], length);
+        }
     }
 #endif
+
+    if (metrics) {
+        METRIC_ADD(metrics->counts.emitted[severity], 1);
+    }
+    recordLatency(metrics, start);
 }
 
 /// List of destination sets by severity level.
@@ -228,3 +573,75 @@ void faLogAssertionFail(const char *filename, uint32_t line, const char *express
     faLog(filename, line, FA_LOG_LEVEL_CRITICAL, "ERROR: assert(%s) failed", expression);
     exit(1);
 }
+
+// Select the format for all following log records.
+void faLogSetFormat(FaLogFormat format)
+{
+    g_logFormat = format;
+}
+
+// Sum up the metrics of all threads.
+void faLogGetMetrics(FaLogMetrics *metrics)
+{
+    memset(metrics, 0, sizeof(*metrics));
+    pthread_mutex_lock(&g_metricsLock);
+    addMetrics(metrics, &g_retiredMetrics);
+    for (LogThreadMetrics *p = g_metricsList; p != NULL; p = p->next) {
+        addMetrics(metrics, &p->counts);
+    }
+    pthread_mutex_unlock(&g_metricsLock);
+}
+
+/// Append to a report being built by \ref faLogDumpMetrics.
+static void appendReport(char *buffer, size_t size, int *length, const char *format, ...) FA_PRINTF_ARGS(4,5);
+static void appendReport(char *buffer, size_t size, int *length, const char *format, ...)
+{
+    if (*length < 0) {
+        return;
+    }
+    size_t used = (size_t)*length;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(used < size ? &buffer[used] : NULL, used < size ? size - used : 0, format, args);
+    va_end(args);
+    *length = (n < 0) ? n : *length + n;
+}
+
+// Format the metrics as text.
+int faLogDumpMetrics(char *buffer, size_t size)
+{
+    static const char *destinationNames[FA_LOG_NUM_DESTINATIONS] = {
+        "none", "console", "syslog", "cbuffer"
+    };
+    FaLogMetrics m;
+    faLogGetMetrics(&m);
+
+    int length = 0;
+    if (size > 0) {
+        buffer[0] = '\0';
+    }
+    appendReport(buffer, size, &length, "%-8s %12s %12s\n", "level", "emitted", "dropped");
+    for (FaLogLevel i = 0; i < FA_LOG_NUM_LEVELS; ++i) {
+        appendReport(buffer, size, &length, "%-8s %12llu %12llu\n", logLevelName(i),
+                     (unsigned long long)m.emitted[i], (unsigned long long)m.dropped[i]);
+    }
+    for (unsigned i = 0; i < FA_LOG_NUM_DESTINATIONS; ++i) {
+        if (m.bytes[i] != 0) {
+            appendReport(buffer, size, &length, "bytes to %s: %llu\n", destinationNames[i],
+                         (unsigned long long)m.bytes[i]);
+        }
+    }
+    uint64_t calls = 0;
+    for (unsigned i = 0; i < FA_LOG_LATENCY_BUCKETS; ++i) {
+        calls += m.latency[i];
+    }
+    appendReport(buffer, size, &length, "faLog calls: %llu, mean %llu ns\n", (unsigned long long)calls,
+                 (unsigned long long)(calls ? m.latencyTotalNs / calls : 0));
+    for (unsigned i = 0; i < FA_LOG_LATENCY_BUCKETS; ++i) {
+        if (m.latency[i] != 0) {
+            appendReport(buffer, size, &length, "  >= %10llu ns: %llu\n", 1ULL << i,
+                         (unsigned long long)m.latency[i]);
+        }
+    }
+    return length;
+}
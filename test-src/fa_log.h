@@ -52,6 +52,14 @@ typedef enum FaLogDestination {
 /// bitwise-or the values together.
 typedef int FaLogDestinationSet;
 
+/// Select how a log record is rendered before it is sent to the destinations.
+typedef enum FaLogFormat {
+    FA_LOG_FORMAT_TEXT, ///< "file:line: [LEVEL] message" (the default)
+    /// One JSON object per line with the keys "ts" (UTC, millisecond
+    /// resolution), "tid", "level", "file", "line" and "msg".
+    FA_LOG_FORMAT_JSON,
+} FaLogFormat;
+
 /// Log a critical error - one that the system cannot recover from without
 /// rebooting.
 /// @param [in] ... printf style format string and additional parameters as
@@ -153,4 +161,51 @@ void faLogInitialize(FaLogLevel minimumSeverity, FaLogDestinationSet destination
 ///                 together the desired \ref FaLogDestination values.
 void faLogConfigureFile(const char *filename, FaLogLevel minimumSeverity, FaLogDestinationSet destinations);
 
+/// Select the format used for all log records from now on. The setting is
+/// kept across calls to \ref faLogInitialize.
+///
+/// \ref FA_LOG_FORMAT_JSON produces JSON lines that can be ingested without
+/// any pattern matching. The timestamp comes from a coarse clock that is
+/// cached per thread, so it is only as precise as the kernel tick.
+///
+/// \param [in] format the \ref FaLogFormat to use.
+void faLogSetFormat(FaLogFormat format);
+
+/// Number of bit positions used by \ref FaLogDestination. Byte counters are
+/// indexed by bit position, e.g. bytes[1] is for \ref FA_LOG_DEST_CONSOLE.
+#define FA_LOG_NUM_DESTINATIONS 4
+
+/// Number of buckets in the \ref faLog latency histogram. Bucket \c i counts
+/// the calls that took between 2^i and 2^(i+1) nanoseconds. The last bucket
+/// also holds everything slower than that.
+#define FA_LOG_LATENCY_BUCKETS 32
+
+/// Counters describing the cost of logging. They are gathered per thread and
+/// summed up by \ref faLogGetMetrics, so recording them never contends.
+typedef struct FaLogMetrics {
+    /// Records sent to at least one destination, by severity.
+    uint64_t emitted[FA_LOG_NUM_LEVELS];
+    /// Records that were filtered out and never formatted, by severity.
+    uint64_t dropped[FA_LOG_NUM_LEVELS];
+    /// Bytes written, by \ref FaLogDestination bit position.
+    uint64_t bytes[FA_LOG_NUM_DESTINATIONS];
+    /// Time spent inside \ref faLog. See \ref FA_LOG_LATENCY_BUCKETS.
+    uint64_t latency[FA_LOG_LATENCY_BUCKETS];
+    /// Total time spent inside \ref faLog, in nanoseconds.
+    uint64_t latencyTotalNs;
+} FaLogMetrics;
+
+/// Take a snapshot of the logging metrics. Counts from threads that have
+/// exited are included.
+/// \param [out] metrics where to store the totals.
+void faLogGetMetrics(FaLogMetrics *metrics);
+
+/// Write a human readable report of the logging metrics to \p buffer. The
+/// output is truncated to fit, and is always nul terminated if \p size is not
+/// zero.
+/// \param [out] buffer where the report is written.
+/// \param [in] size the size of \p buffer.
+/// \return the length of the full report, like snprintf.
+int faLogDumpMetrics(char *buffer, size_t size);
+
 #endif
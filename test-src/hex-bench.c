@@ -0,0 +1,155 @@
+// Copyright (C) 2017 BRK Brands, Inc. All Rights Reserved.
+/// @file
+/// Benchmark of the hex codecs in util.c against the sprintf/sscanf loops they
+/// replaced, for exporting MD5 digests and keys in bulk. Build and run with
+///
+///     gcc -O2 -I. -o hex-bench hex-bench.c util.c -lcrypto && ./hex-bench
+///
+/// Pass UTIL_NO_SIMD (-DUTIL_NO_SIMD) to measure the table driven code alone.
+
+#include "util.h"
+#include <openssl/md5.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DIGEST_COUNT    200000
+/// sscanf measures the rest of the string every time, so the old loop is
+/// quadratic in the length and this can't be much bigger.
+#define EXPORT_BYTES    (64 * 1024)
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/// The old bytesHexlify.
+static char *sprintfHexlify(char *str, const uint8_t *bytes, size_t byteSize)
+{
+    char *ptr = str;
+    for (size_t i = 0; i < byteSize; ++i) {
+        ptr += sprintf(ptr, "%02x", (unsigned int)bytes[i]);
+    }
+    return str;
+}
+
+/// The old bytesUnHexlify.
+static int sscanfUnHexlify(uint8_t *hexByte, const char *hexStr, size_t byteLen)
+{
+    for (size_t count = 0; count < byteLen; count++) {
+        if (sscanf(hexStr + 2 * count, "%2hhx", &hexByte[count]) != 1) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/// md5String of every message, with either hexlify.
+static double digests(char (*messages)[32], char (*out)[MD5_STRING_LEN], bool old)
+{
+    double start = now();
+    for (int i = 0; i < DIGEST_COUNT; i++) {
+        uint8_t digest[MD5_BYTE_LEN];
+        MD5((const unsigned char *)messages[i], strlen(messages[i]), digest);
+        if (old) {
+            sprintfHexlify(out[i], digest, sizeof(digest));
+        } else {
+            bytesHexlify(out[i], digest, sizeof(digest));
+        }
+    }
+    return now() - start;
+}
+
+/// Hexlify every key, then read them back.
+static double keys(const uint8_t *keyBytes, char *text, uint8_t *back, bool old)
+{
+    double start = now();
+    for (int i = 0; i < DIGEST_COUNT; i++) {
+        if (old) {
+            sprintfHexlify(text + i * KEY_STRING_LEN, keyBytes + i * KEY_BYTE_LEN, KEY_BYTE_LEN);
+        } else {
+            bytesHexlify(text + i * KEY_STRING_LEN, keyBytes + i * KEY_BYTE_LEN, KEY_BYTE_LEN);
+        }
+    }
+    for (int i = 0; i < DIGEST_COUNT; i++) {
+        int status = old ? sscanfUnHexlify(back + i * KEY_BYTE_LEN, text + i * KEY_STRING_LEN, KEY_BYTE_LEN)
+                         : bytesUnHexlify(back + i * KEY_BYTE_LEN, text + i * KEY_STRING_LEN, KEY_BYTE_LEN);
+        if (status != 0) {
+            return -1;
+        }
+    }
+    return now() - start;
+}
+
+/// One big buffer each way.
+static double bulk(const uint8_t *bytes, char *text, uint8_t *back, bool old)
+{
+    double start = now();
+    if (old) {
+        sprintfHexlify(text, bytes, EXPORT_BYTES);
+        if (sscanfUnHexlify(back, text, EXPORT_BYTES) != 0) {
+            return -1;
+        }
+    } else {
+        bytesHexlify(text, bytes, EXPORT_BYTES);
+        if (bytesUnHexlify(back, text, EXPORT_BYTES) != 0) {
+            return -1;
+        }
+    }
+    return now() - start;
+}
+
+int main(void)
+{
+    char (*messages)[32] = malloc(DIGEST_COUNT * sizeof(*messages));
+    char (*oldDigests)[MD5_STRING_LEN] = malloc(DIGEST_COUNT * sizeof(*oldDigests));
+    char (*newDigests)[MD5_STRING_LEN] = malloc(DIGEST_COUNT * sizeof(*newDigests));
+    uint8_t *keyBytes = malloc(DIGEST_COUNT * KEY_BYTE_LEN);
+    char *oldText = malloc(DIGEST_COUNT * KEY_STRING_LEN);
+    char *newText = malloc(DIGEST_COUNT * KEY_STRING_LEN);
+    uint8_t *back = malloc(DIGEST_COUNT * KEY_BYTE_LEN > EXPORT_BYTES ? DIGEST_COUNT * KEY_BYTE_LEN : EXPORT_BYTES);
+    uint8_t *bytes = malloc(EXPORT_BYTES);
+    char *bulkText = malloc(2 * EXPORT_BYTES + 1);
+
+    if (!messages || !oldDigests || !newDigests || !keyBytes || !oldText || !newText || !back || !bytes || !bulkText
+        || !getRandomBytes(keyBytes, DIGEST_COUNT * KEY_BYTE_LEN) || !getRandomBytes(bytes, EXPORT_BYTES)) {
+        fprintf(stderr, "setup failed\n");
+        return 1;
+    }
+    for (int i = 0; i < DIGEST_COUNT; i++) {
+        snprintf(messages[i], sizeof(messages[i]), "device-%d", i);
+    }
+
+    double oldTime = digests(messages, oldDigests, true);
+    double newTime = digests(messages, newDigests, false);
+    printf("%d md5 digests:  sprintf %8.2f ms  table/SIMD %8.2f ms  %s\n", DIGEST_COUNT,
+           oldTime * 1e3, newTime * 1e3,
+           memcmp(oldDigests, newDigests, DIGEST_COUNT * sizeof(*oldDigests)) == 0 ? "same" : "DIFFERENT");
+
+    oldTime = keys(keyBytes, oldText, back, true);
+    newTime = keys(keyBytes, newText, back, false);
+    printf("%d keys, both ways:  sscanf %8.2f ms  table/SIMD %8.2f ms  %s\n", DIGEST_COUNT,
+           oldTime * 1e3, newTime * 1e3,
+           (oldTime >= 0 && newTime >= 0 && memcmp(back, keyBytes, DIGEST_COUNT * KEY_BYTE_LEN) == 0
+            && memcmp(oldText, newText, DIGEST_COUNT * KEY_STRING_LEN) == 0) ? "same" : "DIFFERENT");
+
+    oldTime = bulk(bytes, bulkText, back, true);
+    newTime = bulk(bytes, bulkText, back, false);
+    printf("%d KB, both ways:  sprintf/sscanf %8.2f ms  table/SIMD %8.2f ms  %s\n", EXPORT_BYTES >> 10,
+           oldTime * 1e3, newTime * 1e3,
+           (oldTime >= 0 && newTime >= 0 && memcmp(back, bytes, EXPORT_BYTES) == 0) ? "same" : "DIFFERENT");
+
+    free(messages);
+    free(oldDigests);
+    free(newDigests);
+    free(keyBytes);
+    free(oldText);
+    free(newText);
+    free(back);
+    free(bytes);
+    free(bulkText);
+    return 0;
+}
@@ -50,6 +50,9 @@ typedef enum {
 
 /// Information about the body of an HTTP response. If data is != NULL, the
 /// caller is responsible for freeing the memory pointed to by data.
+/// \ref extractResponseBody always nul terminates data, so a JSON body can be
+/// parsed with cJSON_ParseInSitu without copying its strings. data must then
+/// be freed after the cJSON tree.
 typedef struct ResponseData {
     char *data;
     uint32_t size;
@@ -14,7 +14,7 @@
 #include "cia.h"
 #include "http.h"
 #include "fa_log.h"
-#include "cJSON.h"
+#include "command.h"
 
 //#define LOCALHOST       "127.0.0.1"
 #define LOCALHOST       "10.2.27.213"
@@ -61,40 +61,37 @@ bool makePost(const char *message)
 
 static bool setupWifi(void)
 {
-    cJSON *root = cJSON_CreateObject();
-    cJSON *wifi = cJSON_CreateObject();
-    cJSON_AddStringToObject(wifi, "ssid", TEST_SSID);
-    cJSON_AddStringToObject(wifi, "passwd", TEST_PASS);
-    cJSON_AddItemToObject(root, "wifi", wifi);
-    char *message = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-
-    bool status = makePost(message);
-    free(message);
-    return status;
+    char message[SetupWifiCommandMaxLength + 1];
+    SetupWifiCommand command = { .ssid = TEST_SSID, .passwd = TEST_PASS };
+    if (encodeSetupWifiCommand(&command, message, sizeof(message)) == 0) {
+        FA_ERROR("Failed to encode the setupWifi command");
+        return false;
+    }
+
+    return makePost(message);
 }
 static bool factoryReset(void)
 {
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddBoolToObject(root, "reset", cJSON_True);
-    char *message = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-
-    bool status = makePost(message);
-    free(message);
-    return status;
+    char message[FactoryResetCommandMaxLength + 1];
+    FactoryResetCommand command = { .reset = true };
+    if (encodeFactoryResetCommand(&command, message, sizeof(message)) == 0) {
+        FA_ERROR("Failed to encode the factoryReset command");
+        return false;
+    }
+
+    return makePost(message);
 }
 
 static bool selfDiagose(void)
 {
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddBoolToObject(root, "selfDiagosis", cJSON_True);
-    char *message = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-
-    bool status = makePost(message);
-    free(message);
-    return status;
+    char message[SelfDiagnosisCommandMaxLength + 1];
+    SelfDiagnosisCommand command = { .selfDiagosis = true };
+    if (encodeSelfDiagnosisCommand(&command, message, sizeof(message)) == 0) {
+        FA_ERROR("Failed to encode the selfDiagose command");
+        return false;
+    }
+
+    return makePost(message);
 }
 
 
@@ -11,6 +11,35 @@
 #include <fcntl.h>
 #include <unistd.h>
 
+/// SSSE3 and AVX2 versions of the hex codecs on x86, picked at runtime.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(UTIL_NO_SIMD)
+#define UTIL_SIMD_X86
+#include <immintrin.h>
+#endif
+
+/// Hex digits, indexed by nibble.
+static const char hexDigits[] = "0123456789abcdef";
+
+/// Value of every hex digit, either case, and -1 for every other character.
+static const int8_t hexValues[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
 
 
 /**
@@ -27,20 +56,134 @@ bool getRandomBytes(uint8_t *key, size_t keysize)
     int fd = open("/dev/urandom", O_RDONLY);
     if (fd > 0)
     {
-        ssize_t n = read(fd, key, keysize);
-        if (n > 0)
+        // big requests can come back in pieces
+        size_t done = 0;
+        while (done < keysize)
         {
-            success = true;
-        }
-        else
-        {
-            //FA_ERROR("Failed to read /dev/urandom");
+            ssize_t n = read(fd, key + done, keysize - done);
+            if (n <= 0)
+            {
+                //FA_ERROR("Failed to read /dev/urandom");
+                break;
+            }
+            done += (size_t)n;
         }
+        success = (done == keysize);
         close(fd);
     }
     return success;
 }
 
+#if defined(UTIL_SIMD_X86)
+/// Hexlify 16 bytes at a time.
+/// @return the number of bytes done, the rest is left to the caller.
+__attribute__((target("ssse3")))
+static size_t hexlifySsse3(char *str, const uint8_t *bytes, size_t byteSize)
+{
+    const __m128i digits = _mm_loadu_si128((const __m128i *)(const void *)hexDigits);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    size_t done = 0;
+
+    for (; byteSize - done >= 16; done += 16) {
+        __m128i in = _mm_loadu_si128((const __m128i *)(const void *)(bytes + done));
+        __m128i high = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(in, 4), nibble));
+        __m128i low = _mm_shuffle_epi8(digits, _mm_and_si128(in, nibble));
+        _mm_storeu_si128((__m128i *)(void *)(str + 2 * done), _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128((__m128i *)(void *)(str + 2 * done + 16), _mm_unpackhi_epi8(high, low));
+    }
+    return done;
+}
+
+/// Hexlify 32 bytes at a time.
+/// @return the number of bytes done, the rest is left to the caller.
+__attribute__((target("avx2")))
+static size_t hexlifyAvx2(char *str, const uint8_t *bytes, size_t byteSize)
+{
+    const __m256i digits = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(const void *)hexDigits));
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    size_t done = 0;
+
+    for (; byteSize - done >= 32; done += 32) {
+        __m256i in = _mm256_loadu_si256((const __m256i *)(const void *)(bytes + done));
+        __m256i high = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble));
+        __m256i low = _mm256_shuffle_epi8(digits, _mm256_and_si256(in, nibble));
+        // unpack works within 128 bit lanes, put the lanes back in order
+        __m256i first = _mm256_unpacklo_epi8(high, low);
+        __m256i second = _mm256_unpackhi_epi8(high, low);
+        _mm256_storeu_si256((__m256i *)(void *)(str + 2 * done), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256((__m256i *)(void *)(str + 2 * done + 32), _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    return done;
+}
+
+/// The values of 16 hex digits. Sets bits in invalid for the characters that
+/// aren't hex digits.
+__attribute__((target("ssse3")))
+static inline __m128i hexValuesSsse3(__m128i chars, int *invalid)
+{
+    __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    __m128i letter = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    __m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+
+    *invalid |= _mm_movemask_epi8(_mm_or_si128(isDigit, isLetter)) ^ 0xffff;
+    return _mm_or_si128(_mm_and_si128(isDigit, digit),
+                        _mm_and_si128(isLetter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+}
+
+/// Unhexlify 16 bytes at a time.
+/// @return the number of bytes done, or -1 if a character isn't a hex digit.
+__attribute__((target("ssse3")))
+static ssize_t unhexlifySsse3(uint8_t *hexByte, const char *hexStr, size_t byteLen)
+{
+    // high nibble * 16 + low nibble
+    const __m128i weights = _mm_set1_epi16(0x0110);
+    int invalid = 0;
+    size_t done = 0;
+
+    for (; byteLen - done >= 16; done += 16) {
+        __m128i first = hexValuesSsse3(_mm_loadu_si128((const __m128i *)(const void *)(hexStr + 2 * done)), &invalid);
+        __m128i second = hexValuesSsse3(_mm_loadu_si128((const __m128i *)(const void *)(hexStr + 2 * done + 16)), &invalid);
+        _mm_storeu_si128((__m128i *)(void *)(hexByte + done),
+                         _mm_packus_epi16(_mm_maddubs_epi16(first, weights), _mm_maddubs_epi16(second, weights)));
+    }
+    return invalid ? -1 : (ssize_t)done;
+}
+
+/// The values of 32 hex digits, see hexValuesSsse3.
+__attribute__((target("avx2")))
+static inline __m256i hexValuesAvx2(__m256i chars, int *invalid)
+{
+    __m256i digit = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+    __m256i letter = _mm256_sub_epi8(_mm256_or_si256(chars, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    __m256i isDigit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    __m256i isLetter = _mm256_cmpeq_epi8(_mm256_min_epu8(letter, _mm256_set1_epi8(5)), letter);
+
+    *invalid |= ~_mm256_movemask_epi8(_mm256_or_si256(isDigit, isLetter));
+    return _mm256_or_si256(_mm256_and_si256(isDigit, digit),
+                           _mm256_and_si256(isLetter, _mm256_add_epi8(letter, _mm256_set1_epi8(10))));
+}
+
+/// Unhexlify 32 bytes at a time.
+/// @return the number of bytes done, or -1 if a character isn't a hex digit.
+__attribute__((target("avx2")))
+static ssize_t unhexlifyAvx2(uint8_t *hexByte, const char *hexStr, size_t byteLen)
+{
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+    int invalid = 0;
+    size_t done = 0;
+
+    for (; byteLen - done >= 32; done += 32) {
+        __m256i first = hexValuesAvx2(_mm256_loadu_si256((const __m256i *)(const void *)(hexStr + 2 * done)), &invalid);
+        __m256i second = hexValuesAvx2(_mm256_loadu_si256((const __m256i *)(const void *)(hexStr + 2 * done + 32)), &invalid);
+        // pack works within 128 bit lanes, put the quarters back in order
+        __m256i packed = _mm256_packus_epi16(_mm256_maddubs_epi16(first, weights), _mm256_maddubs_epi16(second, weights));
+        _mm256_storeu_si256((__m256i *)(void *)(hexByte + done), _mm256_permute4x64_epi64(packed, 0xd8));
+    }
+    return invalid ? -1 : (ssize_t)done;
+}
+#endif
+
 /**
  * @brief      Convert bytes array to a hexdecimal string. Caller needs to make
  *             sure the string size is 2*bytesSize+1.
@@ -51,48 +194,89 @@ bool getRandomBytes(uint8_t *key, size_t keysize)
  *
  * @return     the pointer to the output string for chain use
  */
-char* bytesHexlify(char *str, uint8_t *bytes, size_t byteSize)
+char* bytesHexlify(char *str, const uint8_t *bytes, size_t byteSize)
 {
-    char *ptr = str;
-    for (size_t i = 0; i < byteSize; ++i)
+    size_t done = 0;
+
+#if defined(UTIL_SIMD_X86)
+    // the AVX2 and SSSE3 loops are separate functions, so the switch between
+    // the two instruction encodings happens on return, where it is cheap
+    if (byteSize >= 32 && __builtin_cpu_supports("avx2"))
+    {
+        done = hexlifyAvx2(str, bytes, byteSize);
+    }
+    if (byteSize - done >= 16 && __builtin_cpu_supports("ssse3"))
+    {
+        done += hexlifySsse3(str + 2 * done, bytes + done, byteSize - done);
+    }
+#endif
+
+    for (; done < byteSize; ++done)
     {
-        ptr += sprintf(ptr, "%02x", (unsigned int)bytes[i]);
+        str[2 * done] = hexDigits[bytes[done] >> 4];
+        str[2 * done + 1] = hexDigits[bytes[done] & 0x0f];
     }
+    str[2 * byteSize] = '\0';
     return str;
 }
 
 /**
  * @brief      Convert a hexdecimal string to its byte form
  *
- * @param[in]  hexStr   The hexadecimal string
+ * @param[in]  hexStr   The hexadecimal string, 2*byteLen digits of either case
  * @param[out] hexByte  The hexadecimal byte
  * @param[in]  byteLen  The byte array length
  *
- * @return     0 if success and -1 if failed.
+ * @return     0 if success and -1 if failed, i.e. hexStr is too short or
+ *             has a character that is not a hex digit.
  */
 int bytesUnHexlify(uint8_t *hexByte, const char *hexStr, size_t byteLen)
 {
-    int status = 0;
+    size_t done = 0;
 
-    if (hexStr && hexByte)
+    if (hexStr == NULL || hexByte == NULL || byteLen > SIZE_MAX / 2)
     {
-        const char *pos = hexStr;
-
-        for(size_t count = 0; count < byteLen; count++) {
-            int n = sscanf(pos, "%2hhx", &hexByte[count]);
-            if (n == 1) {
-                pos += 2 * sizeof(char);
-            } else {
-                status = -1;
-                break; // No matching characters
-            }
+        return -1;
+    }
+    // the vector loops read whole blocks, so make sure they stay in the string
+    if (memchr(hexStr, '\0', 2 * byteLen) != NULL)
+    {
+        return -1;
+    }
+
+#if defined(UTIL_SIMD_X86)
+    ssize_t vectorDone = 0;
+    if (byteLen >= 32 && __builtin_cpu_supports("avx2"))
+    {
+        vectorDone = unhexlifyAvx2(hexByte, hexStr, byteLen);
+        if (vectorDone < 0)
+        {
+            return -1;
+        }
+        done = (size_t)vectorDone;
+    }
+    if (byteLen - done >= 16 && __builtin_cpu_supports("ssse3"))
+    {
+        vectorDone = unhexlifySsse3(hexByte + done, hexStr + 2 * done, byteLen - done);
+        if (vectorDone < 0)
+        {
+            return -1;
         }
+        done += (size_t)vectorDone;
     }
-    else
+#endif
+
+    for (; done < byteLen; done++)
     {
-        status = -1;
+        int high = hexValues[(uint8_t)hexStr[2 * done]];
+        int low = hexValues[(uint8_t)hexStr[2 * done + 1]];
+        if ((high | low) < 0)
+        {
+            return -1;
+        }
+        hexByte[done] = (uint8_t)((high << 4) | low);
     }
-    return status;
+    return 0;
 }
 
 /**
@@ -140,21 +324,89 @@ char* uuid4String(char *str, uint8_t *key)
  */
 uint8_t *uuid4Key(uint8_t *key)
 {
-    if (getRandomBytes(key, UUID_BYTE_LEN))
+    return uuid4Keys((uint8_t (*)[UUID_BYTE_LEN])key, 1) ? key : NULL;
+}
+
+/**
+ * @brief      Fill count UUIDs from one read of the random source
+ *
+ * @param      keys  The array of count UUIDs
+ * @param[in]  count The number of UUIDs
+ *
+ * @return     true if success or false if otherwise
+ */
+bool uuid4Keys(uint8_t (*keys)[UUID_BYTE_LEN], size_t count)
+{
+    if (keys == NULL || count > SIZE_MAX / UUID_BYTE_LEN
+        || !getRandomBytes(keys[0], count * UUID_BYTE_LEN))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++)
     {
         // Set UUID version to 4 --- truly random generation
-        key[6] = (key[6] & 0x0F) | 0x40;
+        keys[i][6] = (keys[i][6] & 0x0F) | 0x40;
         // Set the UUID variant to DCE
-        key[8] = (key[8] & 0x3F) | 0x80;
+        keys[i][8] = (keys[i][8] & 0x3F) | 0x80;
+    }
+    return true;
+}
+
+/**
+ * @brief      Generate count version 4 UUID strings, see uuid4String
+ *
+ * @param      strs  The array of count UUID strings
+ * @param      keys  The array of count UUIDs, filled with new UUIDs
+ * @param[in]  count The number of UUIDs
+ *
+ * @return     true if success or false if otherwise
+ */
+bool uuid4Strings(char (*strs)[UUID_STRING_LEN], uint8_t (*keys)[UUID_BYTE_LEN], size_t count)
+{
+    if (strs == NULL || !uuid4Keys(keys, count))
+    {
+        return false;
+    }
 
-        return key;
+    for (size_t i = 0; i < count; i++)
+    {
+        bytesHexlify(strs[i], keys[i], UUID_BYTE_LEN);
+    }
+    return true;
+}
+
+#if defined(UTIL_SIMD_X86) && defined(__SSE2__)
+/// Check that 16 characters are lowercase hex digits.
+static inline bool lowerHex16(const char *str)
+{
+    __m128i chars = _mm_loadu_si128((const __m128i *)(const void *)str);
+    __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    __m128i letter = _mm_sub_epi8(chars, _mm_set1_epi8('a'));
+    __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    __m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+
+    return _mm_movemask_epi8(_mm_or_si128(isDigit, isLetter)) == 0xffff;
+}
+#else
+/// Check that 16 characters are lowercase hex digits.
+static inline bool lowerHex16(const char *str)
+{
+    for (int i = 0; i < 16; i++)
+    {
+        if (hexValues[(uint8_t)str[i]] < 0 || (str[i] >= 'A' && str[i] <= 'F'))
+        {
+            return false;
+        }
     }
-    return NULL;
+    return true;
 }
+#endif
 
 /**
- * @brief      Check input is in a valid UUID4 string format as
- *             xxxxxxxx-xxxx-4xxx-Nxxx-xxxxxxxxxxxx
+ * @brief      Check input is in a valid UUID4 string format as made by
+ *             uuid4String, 32 lowercase hex digits without dashes:
+ *             xxxxxxxxxxxx4xxxNxxxxxxxxxxxxxxx, N is one of 8, 9, a or b
  *
  * @param[in]  id    The input string
  *
@@ -162,7 +414,8 @@ uint8_t *uuid4Key(uint8_t *key)
  */
 bool validUUID4(const char *id)
 {
-    if (strlen(id) != (UUID_STRING_LEN - 1)) {
+    // the 32 characters can only be loaded at once if the string is that long
+    if (id == NULL || memchr(id, '\0', UUID_STRING_LEN - 1) != NULL || id[UUID_STRING_LEN - 1] != '\0') {
         return false;
     }
     if (id[12] != '4') {
@@ -171,7 +424,33 @@ bool validUUID4(const char *id)
     if (id[16]<'8' || (id[16]>'9' && id[16]<'a') || id[16]>'b') {
         return false;
     }
-    return true;
+    return lowerHex16(id) && lowerHex16(id + 16);
+}
+
+/**
+ * @brief      Check a list of UUID4 strings, see validUUID4
+ *
+ * @param[in]  ids    The input strings
+ * @param[in]  count  The number of strings
+ * @param[out] valid  If not NULL, whether each string is valid
+ *
+ * @return     the number of valid strings
+ */
+size_t validUUID4List(const char *const *ids, size_t count, bool *valid)
+{
+    size_t validCount = 0;
+
+    if (ids == NULL) {
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        bool ok = validUUID4(ids[i]);
+        if (valid != NULL) {
+            valid[i] = ok;
+        }
+        validCount += ok;
+    }
+    return validCount;
 }
 
  
\ No newline at end of file
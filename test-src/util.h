@@ -38,16 +38,17 @@ bool getRandomBytes(uint8_t *key, size_t keysize);
  *
  * @return     the pointer to the output string for chain use
  */
-char* bytesHexlify(char *str, uint8_t *bytes, size_t byteSize);
+char* bytesHexlify(char *str, const uint8_t *bytes, size_t byteSize);
 
 /**
  * @brief      Convert a hexdecimal string to its byte form
  *
- * @param[in]  hexStr   The hexadecimal string
+ * @param[in]  hexStr   The hexadecimal string, 2*byteLen digits of either case
  * @param[out] hexByte  The hexadecimal byte
  * @param[in]  byteLen  The byte array length
  *
- * @return     0 if success and -1 if failed.
+ * @return     0 if success and -1 if failed, i.e. hexStr is too short or
+ *             has a character that is not a hex digit.
  */
 int bytesUnHexlify(uint8_t *hexByte, const char *hexStr, size_t byteLen);
 
@@ -83,8 +84,30 @@ uint8_t *uuid4Key(uint8_t *key);
 
 
 /**
- * @brief      Check input is in a valid UUID4 string format as
- *             xxxxxxxx-xxxx-4xxx-Nxxx-xxxxxxxxxxxx
+ * @brief      Fill count UUIDs from one read of the random source
+ *
+ * @param      keys  The array of count UUIDs
+ * @param[in]  count The number of UUIDs
+ *
+ * @return     true if success or false if otherwise
+ */
+bool uuid4Keys(uint8_t (*keys)[UUID_BYTE_LEN], size_t count);
+
+/**
+ * @brief      Generate count version 4 UUID strings, see uuid4String
+ *
+ * @param      strs  The array of count UUID strings
+ * @param      keys  The array of count UUIDs, filled with new UUIDs
+ * @param[in]  count The number of UUIDs
+ *
+ * @return     true if success or false if otherwise
+ */
+bool uuid4Strings(char (*strs)[UUID_STRING_LEN], uint8_t (*keys)[UUID_BYTE_LEN], size_t count);
+
+/**
+ * @brief      Check input is in a valid UUID4 string format as made by
+ *             uuid4String, 32 lowercase hex digits without dashes:
+ *             xxxxxxxxxxxx4xxxNxxxxxxxxxxxxxxx, N is one of 8, 9, a or b
  *
  * @param[in]  id    The input string
  *
@@ -92,6 +115,17 @@ uint8_t *uuid4Key(uint8_t *key);
  */
 bool validUUID4(const char *id);
 
+/**
+ * @brief      Check a list of UUID4 strings, see validUUID4
+ *
+ * @param[in]  ids    The input strings
+ * @param[in]  count  The number of strings
+ * @param[out] valid  If not NULL, whether each string is valid
+ *
+ * @return     the number of valid strings
+ */
+size_t validUUID4List(const char *const *ids, size_t count, bool *valid);
+
 
  
 